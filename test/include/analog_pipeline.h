@@ -0,0 +1,80 @@
+/*
+ * analog_pipeline.h
+ *
+ * 模拟量输入的周期滤波流水线。通道来自配置 (analog_config_t，格式见 doc/CONFIG_GUIDE.md)，
+ * 每周期对全部通道整批处理：
+ *
+ *   raw (16 位 PDO) -> gain * raw + offset -> 中值 (1/3/5) -> 滑动平均 (1~16) -> 一阶 IIR
+ *   -> 上下限判断 (带回差)，越限/解除时向诊断环写入事件
+ *
+ * 存储按级分组 (SoA)：每级的参数与状态是一段 64 字节对齐的 float 数组，通道数向上取整到
+ * ANALOG_LANES，各级都是无分支的定长循环，编译器可直接向量化。每个通道都执行全部各级
+ * (未启用的级参数取直通值)，历史为定长环 (中值 8 拍、滑动平均 16 拍)，滑动平均按
+ * "年龄 -> 系数" 表做 16 拍加权和，与窗口长度无关。因此每周期开销只随通道数线性增长，
+ * 与各通道的滤波组合无关；周期内不分配内存、不加锁。
+ *
+ * 典型流程与 axis_table.h 相同：
+ *   analog_pipeline_create() -> ecrt_domain_reg_pdo_entry_list(analog_pipeline_regs())
+ *   -> ecrt_master_activate() -> analog_pipeline_bind(ecrt_domain_data())
+ *   -> 每周期 ecrt_domain_process() 之后 analog_pipeline_cycle()
+ */
+
+#ifndef ANALOG_PIPELINE_H
+#define ANALOG_PIPELINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "axis_config.h"
+#include "axis_table.h"
+#include "diag_ring.h"
+#include "ecrt.h"
+
+#define ANALOG_LANES 16   /* 数组长度按此对齐 (AVX-512 一个向量 / SSE 四个向量) */
+
+enum {
+    ANALOG_ALARM_HIGH = 1,
+    ANALOG_ALARM_LOW  = 2,
+};
+
+typedef struct analog_pipeline analog_pipeline_t;
+
+/*
+ * 按通道配置生成流水线，校验每个通道的对象在所属从站的 PDO 映射中为 16 位输入。
+ * 通道应属于同一主站 (多主站时由调用方按主站拆分)。diag 可为 NULL，source 为事件来源编号。
+ * 失败返回 -EINVAL 并在 err 中给出原因，内存不足返回 -ENOMEM。
+ */
+int analog_pipeline_create(const analog_config_t *ch, unsigned int n,
+                           const axis_slave_desc_t *slaves, unsigned int n_slaves,
+                           diag_ring_t *diag, uint16_t source, analog_pipeline_t **out,
+                           char *err, size_t err_len);
+
+/* 供 ecrt_domain_reg_pdo_entry_list() 使用的注册表 (以空项结尾) */
+const ec_pdo_entry_reg_t *analog_pipeline_regs(const analog_pipeline_t *ap);
+
+/* 主站激活后调用，预先计算 PDO 指针 */
+int analog_pipeline_bind(analog_pipeline_t *ap, uint8_t *domain_pd);
+
+/* 周期任务在 ecrt_domain_process() 之后调用 */
+void analog_pipeline_cycle(analog_pipeline_t *ap, uint64_t cycle);
+
+/*
+ * 热加载后刷新滤波参数 (周期线程调用)。通道数量、顺序与映射必须与创建时一致，
+ * 否则返回 -EINVAL 且不做修改。滤波历史保留，不会产生跳变。
+ */
+int analog_pipeline_apply(analog_pipeline_t *ap, const analog_config_t *ch, unsigned int n);
+
+unsigned int analog_pipeline_count(const analog_pipeline_t *ap);
+
+/* 按名称查找通道下标，未找到返回 -1 */
+int analog_pipeline_find(const analog_pipeline_t *ap, const char *name);
+
+/* 最近一个周期的输出 (工程单位)，按通道下标索引；只在周期线程内读取 */
+const float *analog_pipeline_values(const analog_pipeline_t *ap);
+
+/* 通道当前的越限状态 (ANALOG_ALARM_* 按位或) */
+unsigned int analog_pipeline_alarm(const analog_pipeline_t *ap, unsigned int i);
+
+void analog_pipeline_destroy(analog_pipeline_t *ap);
+
+#endif /* ANALOG_PIPELINE_H */
@@ -0,0 +1,135 @@
+/*
+ * axis_config.h
+ *
+ * JSON 配置文件 (格式见 doc/CONFIG_GUIDE.md) 的解析结果：网络参数、从站列表、逻辑轴表、
+ * 模拟量通道 (滤波流水线见 analog_pipeline.h)、数字量输入字 (边沿检测见 di_edge.h)。
+ * 解析为单遍扫描，不构建 DOM；从站与轴数组按实际数量分配，复制请用 axis_config_copy()。
+ * 解析时即检查 axis_id 越界/重复、主站编号重复或未声明、同一主站下从站 id 重复及数值范围；
+ * 与 PDO 映射相关的校验见 axis_table.h。
+ */
+
+#ifndef AXIS_CONFIG_H
+#define AXIS_CONFIG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cycle_sched.h"
+
+#define AXIS_CONFIG_MAX_AXIS_ID 4095  /* axis_id 范围 0 ~ 4095 */
+#define AXIS_CONFIG_PATH_LEN    256
+#define AXIS_CONFIG_MAX_MASTERS 8     /* 每个网口一个主站 */
+
+#define ANALOG_NAME_LEN       32
+#define ANALOG_MAX_AVG_WINDOW 16      /* 滑动平均窗口上限 (状态为定长数组) */
+#define ANALOG_MAX_MEDIAN     5       /* 中值滤波窗口：1 (关闭)、3、5 */
+
+#define AXIS_DEFAULT_ENCODER_RES 131072u
+#define AXIS_DEFAULT_CYCLE_US    4000u
+#define AXIS_DEFAULT_ENI_PATH    "doc/HCFAX3E.xml"
+
+typedef enum {
+    SLAVE_TYPE_CIA402 = 0,  /* 除 "io" 外的任意类型字符串均视为 CiA402 伺服 */
+    SLAVE_TYPE_IO,
+} slave_type_t;
+
+/* 一个主站 (网口) 及其周期线程绑定的 CPU */
+typedef struct {
+    int index;     /* ecrt_request_master() 的主站编号 */
+    int cpu;       /* -1 表示不绑核 */
+} master_config_t;
+
+typedef struct {
+    int          id;        /* 物理从站索引 (所属主站总线上的位置) */
+    int          master;    /* 所属主站编号，默认 0 */
+    slave_type_t type;
+    uint8_t      modbus_gateway;  /* 经本从站 PDO 通道转发 Modbus (见 modbus_gateway.h)，每个主站至多一个 */
+} slave_config_t;
+
+typedef struct {
+    int          axis_id;
+    int          slave_id;
+    int          master;       /* 所属从站的主站编号 */
+    slave_type_t type;
+    uint16_t     offset;       /* 对象字典偏移，多轴驱动器第二轴为 0x800 */
+    uint32_t     encoder_res;
+    double       gear_ratio;
+    double       unit_per_rev;
+    double       scale;        /* 脉冲 / 用户单位 = encoder_res * gear_ratio / unit_per_rev */
+} axis_config_t;
+
+/*
+ * 模拟量输入通道：raw (16 位 PDO) -> gain * raw + offset -> 中值 -> 滑动平均 -> 一阶 IIR
+ * -> 上下限判断 (带回差)。各级取默认值时即为直通。
+ */
+typedef struct {
+    char     name[ANALOG_NAME_LEN];
+    int      slave_id;
+    int      master;        /* 所属从站的主站编号 */
+    uint16_t index;         /* 输入对象索引 (如 F2838x 的 0x6002 ~ 0x6005) */
+    uint8_t  is_signed;     /* raw 按 int16 解释 */
+    uint8_t  median;        /* 1 / 3 / 5 */
+    uint8_t  avg_window;    /* 1 ~ ANALOG_MAX_AVG_WINDOW */
+    uint8_t  has_high;
+    uint8_t  has_low;
+    double   gain;
+    double   offset;
+    double   iir_alpha;     /* (0, 1]，1 表示不做 IIR */
+    double   high;
+    double   low;
+    double   hysteresis;    /* 越限后需回到 high - hysteresis / low + hysteresis 以内才解除 */
+} analog_config_t;
+
+/* 做边沿检测的数字量输入字 (8/16/32 位输入对象，每位一个输入点) */
+typedef struct {
+    int      slave_id;
+    int      master;        /* 所属从站的主站编号 */
+    uint16_t index;         /* 如 INEXBOT 的 0x6000 / 0x6005、HCFA 的 0x60FD、F2838x 的 0x6001 */
+} di_config_t;
+
+/*
+ * 从站与轴的数量在解析时确定 (动态分配)，此后不再变化。
+ * 轴按 (主站, 从站 id, offset) 排序，从站按 (主站, id) 排序：同一主站、同一从站的轴
+ * 在数组中连续，数组下标即周期代码使用的稠密轴下标。
+ * 未配置 network.masters 时只有主站 0。
+ */
+typedef struct {
+    char            eni_path[AXIS_CONFIG_PATH_LEN];
+    uint32_t        cycle_us;
+    cycle_overrun_policy_t overrun_policy;
+    uint32_t        max_catchup;        /* 0 表示 CYCLE_SCHED_DEFAULT_MAX_CATCHUP */
+    uint32_t        safe_after_misses;  /* 0 表示不进入安全态 */
+    unsigned int    n_masters;
+    master_config_t masters[AXIS_CONFIG_MAX_MASTERS];  /* 按 index 排序 */
+    unsigned int    n_slaves;
+    slave_config_t *slaves;
+    unsigned int    n_axes;
+    axis_config_t  *axes;
+    unsigned int    n_analog;
+    analog_config_t *analog;           /* 按 (主站, 从站 id, index) 排序 */
+    unsigned int    n_di;
+    di_config_t    *di;                /* 按 (主站, 从站 id, index) 排序 */
+} axis_config_table_t;
+
+/*
+ * 解析内存中的 JSON 文本。成功返回 0，结果需用 axis_config_free() 释放；
+ * 失败返回 -EINVAL (内存不足为 -ENOMEM)，并在 err (可为 NULL) 中写入带行号的错误描述。
+ */
+int axis_config_parse(const char *text, size_t len, axis_config_table_t *out,
+                      char *err, size_t err_len);
+
+/* 读取并解析配置文件；文件读取失败返回 -errno */
+int axis_config_load(const char *path, axis_config_table_t *out, char *err, size_t err_len);
+
+/* 深拷贝 src 到 dst (dst 须已初始化或清零)；dst 原有数组在容量足够时复用 */
+int axis_config_copy(axis_config_table_t *dst, const axis_config_table_t *src);
+
+/* 两份配置内容完全一致返回 1 */
+int axis_config_equal(const axis_config_table_t *a, const axis_config_table_t *b);
+
+void axis_config_free(axis_config_table_t *tbl);
+
+/* 按 axis_id 查找，未找到返回 NULL */
+const axis_config_t *axis_config_find(const axis_config_table_t *tbl, int axis_id);
+
+#endif /* AXIS_CONFIG_H */
@@ -0,0 +1,64 @@
+/*
+ * axis_mask.h
+ *
+ * 按稠密轴下标编号的位图 (每 64 轴一个 uint64_t)，用于轴组操作。
+ * 位图长度由调用方按 AXIS_MASK_WORDS(n_axes) 分配，周期内不再变化。
+ */
+
+#ifndef AXIS_MASK_H
+#define AXIS_MASK_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define AXIS_MASK_WORDS(n) (((n) + 63u) / 64u)
+
+static inline void axis_mask_clear_all(uint64_t *m, unsigned int n_axes)
+{
+    memset(m, 0, AXIS_MASK_WORDS(n_axes) * sizeof(uint64_t));
+}
+
+static inline void axis_mask_set(uint64_t *m, unsigned int i)
+{
+    m[i >> 6] |= 1ull << (i & 63);
+}
+
+static inline void axis_mask_clear(uint64_t *m, unsigned int i)
+{
+    m[i >> 6] &= ~(1ull << (i & 63));
+}
+
+static inline int axis_mask_test(const uint64_t *m, unsigned int i)
+{
+    return (m[i >> 6] >> (i & 63)) & 1;
+}
+
+/* 置位 [first, first + count) */
+static inline void axis_mask_set_span(uint64_t *m, unsigned int first, unsigned int count)
+{
+    for (unsigned int i = first; i < first + count; i++)
+        axis_mask_set(m, i);
+}
+
+/* 两个位图有交集返回 1 */
+static inline int axis_mask_intersects(const uint64_t *a, const uint64_t *b, unsigned int n_axes)
+{
+    for (unsigned int w = 0; w < AXIS_MASK_WORDS(n_axes); w++) {
+        if (a[w] & b[w])
+            return 1;
+    }
+    return 0;
+}
+
+/*
+ * 遍历位图中的置位下标：
+ *   AXIS_MASK_FOR_EACH(mask, n_axes, i) { ... }
+ * 只在有置位的字上做 ctz，空字直接跳过。循环体中的 break 只结束当前下标 (等同 continue)。
+ */
+#define AXIS_MASK_FOR_EACH(mask, n_axes, i)                                         \
+    for (unsigned int _w = 0, _nw = AXIS_MASK_WORDS(n_axes); _w < _nw; _w++)        \
+        for (uint64_t _bits = (mask)[_w]; _bits; _bits &= _bits - 1)                \
+            for (unsigned int i = _w * 64u + (unsigned int)__builtin_ctzll(_bits),  \
+                              _once = 1; _once; _once = 0)
+
+#endif /* AXIS_MASK_H */
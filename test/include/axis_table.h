@@ -0,0 +1,128 @@
+/*
+ * axis_table.h
+ *
+ * 周期任务使用的稠密轴表。
+ *
+ * axis_table_create() 在总线启动前完成全部校验：配置中的从站必须存在于总线布局中，
+ * type (io / cia402) 必须与从站 PDO 映射一致，每个轴的 offset 对应的对象
+ * (0x6040+offset 等) 必须真实映射在该从站的 PDO 中，方向与位宽与周期代码的访问方式一致
+ * (控制字/状态字/错误码/探针功能与状态 16 位，目标/实际位置与探针位置 32 位，运行模式 8 位)。
+ * 校验通过后生成 domain 注册表；激活主站后 axis_table_bind() 把偏移换算成指针，
+ * 周期代码按下标直接访问，不再做任何查找。
+ *
+ * 存储按字段分组 (SoA)：每个字段是一段 64 字节对齐的连续数组，下标为稠密轴下标，
+ * 轴按从站排序，slaves[] 给出每个从站的下标区间。轴数量在创建时确定，周期内不变。
+ * 轴组操作以位图 (axis_mask.h) 或下标区间为参数，一次调用处理任意数量的轴。
+ *
+ * 典型流程：
+ *   axis_config_load() -> axis_table_create() -> ecrt_domain_reg_pdo_entry_list(axis_table_regs())
+ *   -> ecrt_master_activate() -> axis_table_bind(ecrt_domain_data())
+ */
+
+#ifndef AXIS_TABLE_H
+#define AXIS_TABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "axis_config.h"
+#include "axis_mask.h"
+#include "ecrt.h"
+
+/* 总线布局中的一个从站 (PDO 映射通常来自 ethercat cstruct 生成的 slave_N_syncs) */
+typedef struct {
+    uint16_t               alias;
+    uint16_t               position;
+    uint32_t               vendor_id;
+    uint32_t               product_code;
+    const ec_sync_info_t  *syncs;    /* 以 index == 0xff 结尾 */
+} axis_slave_desc_t;
+
+/* 一个从站在稠密轴数组中的区间 */
+typedef struct {
+    uint16_t     position;
+    uint8_t      type;       /* slave_type_t */
+    unsigned int first;
+    unsigned int count;
+} axis_slave_span_t;
+
+typedef struct axis_table {
+    unsigned int       n_axes;
+    unsigned int       n_slaves;
+    axis_slave_span_t *slaves;
+
+    /* 各字段数组，长度 n_axes；未映射的可选对象为 NULL */
+    uint8_t       **control_word;   /* 0x6040 (IO 轴为 NULL) */
+    uint8_t       **target_pos;     /* 0x607a */
+    uint8_t       **mode_of_op;     /* 0x6060 */
+    const uint8_t **status_word;    /* 0x6041 */
+    const uint8_t **actual_pos;     /* 0x6064 */
+    const uint8_t **mode_display;   /* 0x6061 */
+    const uint8_t **error_code;     /* 0x603f */
+    uint8_t       **probe_func;     /* 0x60b8 Touch Probe Function (可选) */
+    const uint8_t **probe_status;   /* 0x60b9 Touch Probe Status (可选) */
+    const uint8_t **probe_pos;      /* 0x60ba Touch Probe1 Pos1 (可选) */
+    uint8_t       **io_out;         /* IO 轴：数字输出字 */
+    const uint8_t **io_in;          /* IO 轴：数字输入字 */
+    double         *scale;          /* 脉冲 / 用户单位 */
+    double         *inv_scale;      /* 用户单位 / 脉冲 */
+    int32_t        *axis_id;
+    uint16_t       *slave_pos;
+    uint8_t        *type;           /* slave_type_t */
+    uint8_t        *io_out_bits;
+    uint8_t        *io_in_bits;
+    uint64_t       *cia402_mask;    /* 所有 CiA402 轴 */
+    uint64_t       *probe_mask;     /* 0x60b8 / 0x60b9 / 0x60ba 均已映射的轴 (见 touch_probe.h) */
+
+    int32_t            *index_of;   /* axis_id -> 稠密下标，-1 表示未配置 */
+    unsigned int        index_of_len;
+    ec_pdo_entry_reg_t *regs;       /* 以空项结尾 */
+    unsigned int       *offsets;    /* regs 对应的偏移输出 */
+    unsigned int        n_regs;
+    int                 bound;
+} axis_table_t;
+
+/*
+ * 校验配置并生成轴表。失败返回 -EINVAL 并在 err 中给出原因 (无效配置不会进入总线启动)。
+ */
+int axis_table_create(const axis_config_table_t *cfg, const axis_slave_desc_t *slaves,
+                      unsigned int n_slaves, axis_table_t **out, char *err, size_t err_len);
+
+/* 供 ecrt_domain_reg_pdo_entry_list() 使用的注册表 */
+const ec_pdo_entry_reg_t *axis_table_regs(const axis_table_t *at);
+
+/* 主站激活后调用，预先计算所有 PDO 指针 */
+int axis_table_bind(axis_table_t *at, uint8_t *domain_pd);
+
+/* 热加载后刷新比例因子 (轴映射不变，只更新 scale / inv_scale) */
+void axis_table_apply_scales(axis_table_t *at, const axis_config_table_t *cfg);
+
+/* axis_id -> 稠密下标，未配置返回 -1 */
+static inline int axis_table_index(const axis_table_t *at, int axis_id)
+{
+    if (axis_id < 0 || (unsigned int)axis_id >= at->index_of_len)
+        return -1;
+    return at->index_of[axis_id];
+}
+
+/* --- 轴组操作 (周期任务调用；数组参数按稠密下标索引，长度 n_axes) --- */
+
+/* 把 mask 中各轴的目标位置 (用户单位) 换算为脉冲写入 0x607a */
+void axis_table_write_targets(axis_table_t *at, const uint64_t *mask, const double *pos);
+
+/* 同上，作用于下标区间 [first, first + count) */
+void axis_table_write_targets_span(axis_table_t *at, unsigned int first, unsigned int count,
+                                   const double *pos);
+
+/* 读取 mask 中各轴的实际位置 (用户单位) */
+void axis_table_read_positions(const axis_table_t *at, const uint64_t *mask, double *pos);
+
+/* 向 mask 中各轴写同一个控制字 */
+void axis_table_write_control(axis_table_t *at, const uint64_t *mask, uint16_t control_word);
+
+/* 根据状态字生成处于 Operation Enabled 的轴位图 (out 长度 AXIS_MASK_WORDS(n_axes)) */
+void axis_table_enabled_mask(const axis_table_t *at, uint64_t *out);
+
+void axis_table_destroy(axis_table_t *at);
+
+#endif /* AXIS_TABLE_H */
@@ -0,0 +1,62 @@
+/*
+ * config_reload.h
+ *
+ * 配置热加载：不停总线修改 gear_ratio / unit_per_rev / encoder_res 等参数。
+ *
+ * 监视线程 (非 RT) 用 inotify 监视配置文件，文件写完或被替换后重新解析、校验，
+ * 写入双缓冲中空闲的一份，再发布为 "待切换"。周期任务在每个周期开始时调用
+ * config_reload_sync()，在周期边界原子地切换到新表 (RCU 风格：RT 线程清除
+ * pending 即表示旧表已不再被引用，监视线程此后才会复用它)。
+ *
+ * 会让驱动器运动的修改 (已使能轴的比例因子变化) 按策略处理：
+ *   CONFIG_RELOAD_HOLD    保留待切换，直到相关轴全部空闲
+ *   CONFIG_RELOAD_REJECT  直接丢弃本次修改
+ * 拓扑变化 (eni_path、主站列表、从站列表、轴到从站/offset 的映射、模拟量通道的增减与映射、
+ * 数字量输入字) 需要重启总线，cycle_us 与超时设置需要重启程序，一律拒绝；模拟量的滤波参数可以修改 (analog_pipeline_apply())。
+ */
+
+#ifndef CONFIG_RELOAD_H
+#define CONFIG_RELOAD_H
+
+#include <stdint.h>
+
+#include "axis_config.h"
+#include "axis_mask.h"
+
+typedef enum {
+    CONFIG_RELOAD_HOLD = 0,
+    CONFIG_RELOAD_REJECT,
+} config_reload_policy_t;
+
+typedef struct {
+    uint32_t generation;     /* 已生效的配置版本，初始为 0 */
+    uint32_t applied;        /* 成功切换次数 */
+    uint32_t rejected;       /* 校验失败或按策略拒绝的次数 */
+    uint32_t held_cycles;    /* 因轴未空闲而推迟的周期数 */
+    int      pending;        /* 当前是否有待切换的配置 */
+    char     last_error[160];  /* 最近一次拒绝的原因 (解析/校验失败，或按 REJECT 策略丢弃) */
+} config_reload_status_t;
+
+typedef struct config_reload config_reload_t;
+
+/*
+ * 以 initial 为当前配置启动监视线程 (内部保存深拷贝，调用后 initial 可释放)。
+ * 成功返回 0，失败返回 -errno。
+ */
+int config_reload_start(const char *path, const axis_config_table_t *initial,
+                        config_reload_policy_t policy, config_reload_t **out);
+
+/*
+ * 周期任务在周期开始处调用，返回本周期应使用的配置表。
+ * enabled_mask 为按稠密轴下标编号的位图 (axis_mask.h，可由 axis_table_enabled_mask() 生成)，
+ * 置位表示该轴当前处于使能 (Operation Enabled) 状态。
+ * 不阻塞、不分配内存、不做系统调用。
+ */
+const axis_config_table_t *config_reload_sync(config_reload_t *cr, const uint64_t *enabled_mask);
+
+/* 读取统计信息 (非 RT 线程调用) */
+void config_reload_get_status(config_reload_t *cr, config_reload_status_t *st);
+
+void config_reload_stop(config_reload_t *cr);
+
+#endif /* CONFIG_RELOAD_H */
@@ -0,0 +1,83 @@
+/*
+ * cycle_sched.h
+ *
+ * 周期调度：按绝对时隙 (start + k * period) 唤醒，检测截止时间错过并按策略恢复。
+ *
+ * 每个周期：
+ *   cycle_sched_wait()   睡到本周期时隙起点，返回时隙号与是否处于安全态
+ *   ... receive / 计算 / send ...
+ *   cycle_sched_done()   以当前时刻检查截止时间 (时隙起点 + deadline_ns)
+ *
+ * 醒来时已落后一个完整周期以上 (前一周期超时或线程被抢占) 按策略处理：
+ *   CYCLE_OVERRUN_SKIP     丢弃落后的时隙，在下一个时隙边界重新对齐
+ *   CYCLE_OVERRUN_CATCHUP  不睡眠连续补跑落后的时隙，最多 max_catchup 个，超出后按 SKIP
+ * 连续 safe_after 个周期错过截止时间后进入安全态 (锁存，直到 cycle_sched_clear_safe())。
+ * 所有事件带时间戳写入 diag_ring。
+ *
+ * 截止时间按时隙统计：每个执行结束时已过截止时间的时隙计一次错过，补跑的时隙必然计入。
+ * 因此 CATCHUP 下一次落后 n 个周期最多产生 1 + min(n, max_catchup) 次连续错过，
+ * 若单次抢占不应触发安全态，safe_after 需大于 max_catchup + 1；SKIP 下同样的落后只计 1 次，
+ * 其余时隙记在 skipped。
+ */
+
+#ifndef CYCLE_SCHED_H
+#define CYCLE_SCHED_H
+
+#include <stdint.h>
+
+#include "diag_ring.h"
+
+typedef enum {
+    CYCLE_OVERRUN_SKIP = 0,
+    CYCLE_OVERRUN_CATCHUP,
+} cycle_overrun_policy_t;
+
+#define CYCLE_SCHED_DEFAULT_MAX_CATCHUP 3
+
+typedef struct {
+    uint32_t               period_ns;
+    uint32_t               deadline_ns;  /* 相对时隙起点，0 表示等于 period_ns */
+    cycle_overrun_policy_t policy;
+    unsigned int           max_catchup;  /* 0 表示 CYCLE_SCHED_DEFAULT_MAX_CATCHUP */
+    unsigned int           safe_after;   /* 连续错过 N 个截止时间进入安全态，0 表示不启用 */
+    diag_ring_t           *diag;         /* 可为 NULL */
+    uint16_t               source;       /* 写入诊断事件的来源编号 */
+} cycle_sched_config_t;
+
+typedef struct {
+    uint64_t cycle;       /* 时隙号 */
+    uint64_t slot_ns;     /* 时隙起点 (CLOCK_MONOTONIC) */
+    uint64_t wake_ns;     /* 实际开始执行的时刻 */
+    int      catchup;     /* 本周期为补跑 */
+    int      safe_state;  /* 处于安全态，周期任务应输出安全值 */
+} cycle_tick_t;
+
+typedef struct {
+    uint64_t cycles;
+    uint64_t deadline_misses;
+    uint64_t skipped;             /* 丢弃的时隙数 */
+    uint64_t caught_up;           /* 补跑的周期数 */
+    uint32_t consecutive_misses;
+    uint32_t max_lateness_ns;     /* 超出截止时间的最大值 */
+    int      safe_state;
+} cycle_sched_stats_t;
+
+typedef struct cycle_sched cycle_sched_t;
+
+/* start_ns 为第 0 个时隙的起点 (CLOCK_MONOTONIC)；成功返回 0，失败返回 -errno */
+int cycle_sched_create(const cycle_sched_config_t *cfg, uint64_t start_ns, cycle_sched_t **out);
+
+/* 睡到下一个时隙并填写 tick (周期线程调用) */
+void cycle_sched_wait(cycle_sched_t *cs, cycle_tick_t *tick);
+
+/* 本周期工作结束 (发送之后) 调用 */
+void cycle_sched_done(cycle_sched_t *cs);
+
+/* 请求退出安全态，在下一次 cycle_sched_wait() 生效 (任意线程) */
+void cycle_sched_clear_safe(cycle_sched_t *cs);
+
+void cycle_sched_get_stats(const cycle_sched_t *cs, cycle_sched_stats_t *st);
+
+void cycle_sched_destroy(cycle_sched_t *cs);
+
+#endif /* CYCLE_SCHED_H */
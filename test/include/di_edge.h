@@ -0,0 +1,108 @@
+/*
+ * di_edge.h
+ *
+ * 数字量输入的边沿检测与事件分发。输入字来自配置 (di_config_t，格式见 doc/CONFIG_GUIDE.md)，
+ * 如 INEXBOT 的 0x6000 / 0x6005、HCFA 的 0x60FD、F2838x 的 0x6001。
+ *
+ * 周期任务把全部输入字读入一段 uint32 数组，与上一周期逐字异或；没有变化时只多一次
+ * 按字的 OR 归约。有变化的字整字写入 SPSC 环 (上升沿掩码、下降沿掩码、周期号、时间戳)，
+ * 边沿数用 popcount 计入统计。周期内的开销与输入字数成正比，与位数和订阅数无关。
+ *
+ * 环满 (分发线程跟不上) 时该字的变化不丢弃，而是按位累积，之后每周期连同新变化一起重试。
+ * 积压期间同一位的多次脉冲会合并为一次上升 + 一次下降 (计数偏少，最后分发的边沿与当前
+ * 电平一致)，事件的周期号与时间戳为积压开始的周期，不是各边沿的实际周期。
+ *
+ * 分发线程 (非 RT) 按周期轮询环，用 ctz 逐位展开掩码，调用订阅回调并唤醒
+ * di_edge_wait() 的等待者，应用可以阻塞等待 "第 N 位上升" 而不必每周期轮询输入。
+ *
+ * 位号：第 w 个输入字 (按 (从站 id, index) 排序) 的第 b 位为 w * 32 + b，
+ * 用 di_edge_bit() 由 (从站, index, 位) 换算。
+ *
+ * 典型流程与 analog_pipeline.h 相同：
+ *   di_edge_create() -> ecrt_domain_reg_pdo_entry_list(di_edge_regs())
+ *   -> ecrt_master_activate() -> di_edge_bind(ecrt_domain_data())
+ *   -> 每周期 ecrt_domain_process() 之后 di_edge_cycle()
+ */
+
+#ifndef DI_EDGE_H
+#define DI_EDGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "axis_config.h"
+#include "axis_table.h"
+#include "ecrt.h"
+
+#define DI_EDGE_RING_CAPACITY 1024   /* 周期任务到分发线程的字变化记录数 */
+#define DI_EDGE_MAX_SUBS      64
+
+enum {
+    DI_EDGE_RISING  = 1,
+    DI_EDGE_FALLING = 2,
+    DI_EDGE_BOTH    = 3,
+};
+
+typedef struct {
+    unsigned int bit;       /* 全局位号 */
+    uint8_t      edge;      /* DI_EDGE_RISING / DI_EDGE_FALLING */
+    uint64_t     cycle;     /* 检测到边沿的周期 (环满积压时为积压开始的周期) */
+    uint64_t     time_ns;   /* 该周期的时隙起点 (主机 CLOCK_MONOTONIC) */
+} di_edge_event_t;
+
+/* 在分发线程中调用，不应长时间阻塞 */
+typedef void (*di_edge_fn)(const di_edge_event_t *ev, void *arg);
+
+typedef struct {
+    uint64_t changes;      /* 有变化的字记录数 */
+    uint64_t edges;        /* 边沿数 (上升 + 下降) */
+    uint64_t dropped;      /* 环满未能写入的次数 (变化累积，下一周期重试) */
+    uint64_t dispatched;   /* 已分发的边沿数 */
+} di_edge_stats_t;
+
+typedef struct di_edge di_edge_t;
+
+/*
+ * 按输入字配置创建检测器并启动分发线程，校验每个对象在所属从站的 PDO 映射中为
+ * 8/16/32 位输入。输入字应属于同一主站。cycle_us 为分发线程的轮询间隔。
+ * 失败返回 -EINVAL 并在 err 中给出原因，内存不足返回 -ENOMEM。
+ */
+int di_edge_create(const di_config_t *words, unsigned int n,
+                   const axis_slave_desc_t *slaves, unsigned int n_slaves, uint32_t cycle_us,
+                   di_edge_t **out, char *err, size_t err_len);
+
+/* 供 ecrt_domain_reg_pdo_entry_list() 使用的注册表 (以空项结尾) */
+const ec_pdo_entry_reg_t *di_edge_regs(const di_edge_t *d);
+
+/* 主站激活后调用，预先计算 PDO 指针 */
+int di_edge_bind(di_edge_t *d, uint8_t *domain_pd);
+
+/* 周期任务在 ecrt_domain_process() 之后调用；第一次调用只记录初值，不产生边沿 */
+void di_edge_cycle(di_edge_t *d, uint64_t cycle, uint64_t time_ns);
+
+/* (从站 id, index, 位) 对应的全局位号；未配置或位超出对象宽度返回 -ENOENT */
+int di_edge_bit(const di_edge_t *d, int slave_id, uint16_t index, unsigned int bit);
+
+/* 分发线程看到的当前电平 (0/1)，位号无效返回 -EINVAL */
+int di_edge_level(di_edge_t *d, unsigned int bit);
+
+/* 订阅 bit 的 edges (DI_EDGE_*) 边沿，返回订阅号 (>= 0)；订阅已满返回 -ENOSPC */
+int di_edge_subscribe(di_edge_t *d, unsigned int bit, unsigned int edges, di_edge_fn fn,
+                      void *arg);
+
+/* 取消订阅；返回后回调不会再被调用 (不可在回调中调用) */
+void di_edge_unsubscribe(di_edge_t *d, int id);
+
+/*
+ * 阻塞等待 bit 出现 edges 边沿 (只计调用之后检测到的)，timeout_ms < 0 表示不超时。
+ * 成功返回 0 并填写 ev (可为 NULL)，超时返回 -ETIMEDOUT，检测器销毁返回 -ESHUTDOWN。
+ */
+int di_edge_wait(di_edge_t *d, unsigned int bit, unsigned int edges, int timeout_ms,
+                 di_edge_event_t *ev);
+
+void di_edge_get_stats(const di_edge_t *d, di_edge_stats_t *st);
+
+/* 唤醒全部等待者 (返回 -ESHUTDOWN) 并停止分发线程，须在周期任务停止之后调用 */
+void di_edge_destroy(di_edge_t *d);
+
+#endif /* DI_EDGE_H */
@@ -0,0 +1,68 @@
+/*
+ * diag_ring.h
+ *
+ * 诊断事件环：周期线程把带时间戳的事件 (截止时间错过、跳周期、进入安全态等) 写入
+ * 定长环形缓冲，非 RT 线程取出后打印或上报。
+ *
+ * 多生产者 / 单消费者，无锁：写入只做一次 CAS 与两次原子存储，不分配内存、不做系统调用
+ * (时间戳来自 vDSO 的 clock_gettime)。环满时丢弃新事件并计数，生产者永不阻塞。
+ */
+
+#ifndef DIAG_RING_H
+#define DIAG_RING_H
+
+#include <stdint.h>
+
+typedef enum {
+    DIAG_DEADLINE_MISS = 1,   /* value: 超出截止时间的 ns */
+    DIAG_CYCLES_SKIPPED,      /* value: 跳过的时隙数 */
+    DIAG_CATCHUP,             /* value: 本次补跑落后的时隙数 */
+    DIAG_SAFE_STATE_ENTER,    /* value: 连续错过的周期数 */
+    DIAG_SAFE_STATE_EXIT,
+    DIAG_WKC_MISMATCH,        /* detail: domain 编号，value: working counter */
+    DIAG_WKC_RESTORED,        /* detail: domain 编号，value: working counter */
+    DIAG_FRAME_LOST,          /* detail: domain 编号，value: 本次之前的连续正常周期数 */
+    DIAG_LINK_DOWN,
+    DIAG_LINK_UP,
+    DIAG_SLAVES_RESPONDING,   /* value: 应答的从站数 */
+    DIAG_MASTER_AL_STATE,     /* value: 所有从站 AL 状态按位或 */
+    DIAG_SLAVE_STATE,         /* detail: 从站位置，value: online << 8 | operational << 4 | al_state */
+    DIAG_ANALOG_HIGH,         /* detail: 模拟量通道下标，value: 滤波后的值 x 1000 */
+    DIAG_ANALOG_LOW,          /* 同上 */
+    DIAG_ANALOG_NORMAL,       /* 越限解除，同上 */
+} diag_code_t;
+
+typedef struct {
+    uint64_t timestamp_ns;    /* CLOCK_MONOTONIC */
+    uint64_t cycle;           /* 产生事件的周期号 */
+    int64_t  value;
+    uint16_t code;            /* diag_code_t */
+    uint16_t source;          /* 事件来源 (主站编号等)，由调用方约定 */
+    uint32_t detail;          /* 附加信息 (domain 编号、从站位置等)，含义见 diag_code_t */
+} diag_event_t;
+
+typedef struct diag_ring diag_ring_t;
+
+/* capacity 向上取整为 2 的幂；成功返回 0，失败返回 -errno */
+int diag_ring_create(unsigned int capacity, diag_ring_t **out);
+
+/* 写入事件 (任意线程，RT 安全)；环满返回 -ENOSPC。r 为 NULL 时什么都不做 */
+int diag_ring_push(diag_ring_t *r, diag_code_t code, uint16_t source, uint64_t cycle,
+                   int64_t value);
+
+/* 同上，带附加信息 */
+int diag_ring_push_detail(diag_ring_t *r, diag_code_t code, uint16_t source, uint32_t detail,
+                          uint64_t cycle, int64_t value);
+
+/* 取出最早的事件 (单消费者)；有事件返回 1，环空返回 0 */
+int diag_ring_pop(diag_ring_t *r, diag_event_t *ev);
+
+/* 因环满丢弃的事件数 */
+uint64_t diag_ring_dropped(const diag_ring_t *r);
+
+/* 事件名，用于日志 */
+const char *diag_code_name(uint16_t code);
+
+void diag_ring_destroy(diag_ring_t *r);
+
+#endif /* DIAG_RING_H */
@@ -0,0 +1,85 @@
+/*
+ * health_monitor.h
+ *
+ * 总线健康监视：每周期检查 domain 的 working counter 与主站状态，
+ * 从站 AL 状态轮询 (每周期一个从站)，维护紧凑的计数器，状态变化时向诊断环
+ * 写入边沿事件 (只在变化时写，不逐周期记录)。
+ *
+ * 每周期开销：n_domains 次 ecrt_domain_state()、一次 ecrt_master_state()、
+ * 一次 ecrt_slave_config_state()，无分配、无加锁。计数器为原子变量，
+ * 非 RT 线程可随时读取。
+ *
+ * 判定：
+ *   wc_state == EC_WC_COMPLETE    正常
+ *   wc_state == EC_WC_INCOMPLETE  WKC 不符 (从站掉线、从站未到 OP 等)
+ *   wc_state == EC_WC_ZERO        帧丢失 (没有任何从站处理该帧，多见于线缆/EMI 问题)
+ */
+
+#ifndef HEALTH_MONITOR_H
+#define HEALTH_MONITOR_H
+
+#include <stdint.h>
+
+#include "diag_ring.h"
+#include "ecrt.h"
+
+#define HEALTH_MAX_DOMAINS 4
+
+typedef struct {
+    ec_master_t              *master;
+    ec_domain_t *const       *domains;
+    unsigned int              n_domains;     /* <= HEALTH_MAX_DOMAINS */
+    ec_slave_config_t *const *slaves;        /* 可为 NULL (不轮询从站状态) */
+    const uint16_t           *slave_pos;     /* 与 slaves 对应的从站位置 */
+    unsigned int              n_slaves;
+    diag_ring_t              *diag;          /* 可为 NULL */
+    uint16_t                  source;        /* 事件来源编号 (主站编号) */
+} health_monitor_config_t;
+
+typedef struct {
+    uint32_t working_counter;   /* 最近一次的 WKC */
+    uint32_t expected_wkc;      /* 最近一次 COMPLETE 时的 WKC */
+    uint64_t wkc_mismatches;    /* INCOMPLETE 周期数 */
+    uint64_t lost_frames;       /* ZERO 周期数 */
+    uint32_t mismatch_events;   /* 进入 INCOMPLETE 的次数 */
+    uint32_t lost_events;       /* 进入 ZERO 的次数 */
+    uint8_t  wc_state;          /* ec_wc_state_t */
+} health_domain_stats_t;
+
+typedef struct {
+    uint16_t position;
+    uint8_t  online;
+    uint8_t  operational;
+    uint8_t  al_state;
+    uint32_t state_changes;
+    uint32_t offline_events;
+} health_slave_stats_t;
+
+typedef struct {
+    uint64_t cycles;
+    uint32_t slaves_responding;
+    uint8_t  al_states;
+    uint8_t  link_up;
+    uint32_t link_down_events;
+    uint32_t responding_changes;
+    uint32_t al_state_changes;
+} health_master_stats_t;
+
+typedef struct health_monitor health_monitor_t;
+
+/* 成功返回 0，失败返回 -errno */
+int health_monitor_create(const health_monitor_config_t *cfg, health_monitor_t **out);
+
+/* 周期任务在 ecrt_domain_process() 之后调用 */
+void health_monitor_cycle(health_monitor_t *hm, uint64_t cycle);
+
+/* 读取计数器 (任意线程)；下标越界返回 -EINVAL */
+void health_monitor_master_stats(const health_monitor_t *hm, health_master_stats_t *st);
+int health_monitor_domain_stats(const health_monitor_t *hm, unsigned int i,
+                                health_domain_stats_t *st);
+int health_monitor_slave_stats(const health_monitor_t *hm, unsigned int i,
+                               health_slave_stats_t *st);
+
+void health_monitor_destroy(health_monitor_t *hm);
+
+#endif /* HEALTH_MONITOR_H */
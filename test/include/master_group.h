@@ -0,0 +1,156 @@
+/*
+ * master_group.h
+ *
+ * 多主站 (每个网口一个主站) 并行运行，每个主站一个绑核的周期线程。
+ *
+ * 轴到主站的划分来自配置：从站的 "master" 字段指定所属主站，network.masters 给出
+ * 主站编号与周期线程绑定的 CPU (格式见 doc/CONFIG_GUIDE.md)。配置中的轴已按
+ * (主站, 从站, offset) 排序，每个主站的轴在全局数组中是一段连续区间，各自生成一张
+ * axis_table_t，周期内互不访问。
+ *
+ * 时间基准：所有周期线程共享同一个 epoch (CLOCK_MONOTONIC)，第 k 个周期在
+ * epoch + k * cycle_us 醒来，各主站的收发在主机侧相位对齐。该时刻同时作为 application
+ * time 交给主站，但本模块不配置从站 DC (未调用 ecrt_slave_config_dc，也不做参考时钟同步)，
+ * 从站侧的采样与输出时刻仍取决于各自的 SM 事件，不保证跨从站同步。
+ * 截止时间错过按 network.overrun_policy 处理 (cycle_sched.h)，跳过时隙后仍按
+ * epoch 对齐，不会与其他主站错位；事件写入 master_group_diag() 返回的诊断环。
+ * 每个主站的周期线程在 domain process 之后运行 health_monitor (health_monitor.h)，
+ * WKC 不符、帧丢失、链路与从站状态变化同样写入该诊断环；随后运行本主站的模拟量
+ * 流水线 (analog_pipeline.h)，越限事件也写入该诊断环；然后对配置的数字量输入字做边沿
+ * 检测 (di_edge.h) 和探针锁存检测 (touch_probe.h，连续模式)，配置了 modbus_gateway 的
+ * 从站再由本主站的 Modbus 网关 (modbus_gateway.h) 收发一条事务。启用遥测
+ * (master_group_set_telemetry()) 时，周期线程在发送之后发布本主站轴状态与调度统计的快照。
+ *
+ * 跨主站的一致设定值：规划线程调用 master_group_publish() 预先发布第 k 周期全部轴的
+ * 目标位置。第一个到达第 k 周期的主站线程用 CAS 决定该帧 "采纳" 或 "过期"，其他主站
+ * 线程看到同一结论：要么所有主站在第 k 周期使用同一帧，要么都沿用上一帧，
+ * 不会出现部分主站用新值、部分主站用旧值的情况。帧环槽位在所有主站都过了该帧的
+ * 周期之后才会被复用，严重落后的主站也能看到同一结论。
+ */
+
+#ifndef MASTER_GROUP_H
+#define MASTER_GROUP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "analog_pipeline.h"
+#include "axis_config.h"
+#include "axis_table.h"
+#include "config_reload.h"
+#include "cycle_sched.h"
+#include "di_edge.h"
+#include "diag_ring.h"
+#include "ecrt.h"
+#include "health_monitor.h"
+#include "modbus_gateway.h"
+#include "telemetry_shm.h"
+#include "touch_probe.h"
+
+#define MASTER_GROUP_FRAMES      8   /* 设定值帧环深度，最多提前 FRAMES - 2 个周期发布 */
+#define MASTER_GROUP_RT_PRIORITY 80  /* 周期线程 SCHED_FIFO 优先级 (无权限时沿用默认调度) */
+#define MASTER_GROUP_DIAG_CAPACITY 1024
+
+/* 一个主站的总线布局 */
+typedef struct {
+    int                      master;    /* 主站编号，对应 network.masters[].index */
+    const axis_slave_desc_t *slaves;
+    unsigned int             n_slaves;
+} master_bus_t;
+
+/* 周期回调看到的主站上下文 */
+typedef struct {
+    int           index;           /* 主站编号 */
+    int           cpu;             /* 周期线程绑定的 CPU，-1 表示未绑定 */
+    ec_master_t  *master;
+    ec_domain_t  *domain;
+    uint8_t      *domain_pd;
+    axis_table_t *axes;            /* 本主站轴表 (稠密下标从 0 开始) */
+    analog_pipeline_t *analog;     /* 本主站从站上的模拟量通道 (周期回调前已完成滤波) */
+    di_edge_t    *di;              /* 本主站数字量输入的边沿检测，未配置时为 NULL */
+    modbus_gw_t  *modbus;          /* 本主站的 Modbus 网关，未配置时为 NULL */
+    touch_probe_t *probe;          /* 本主站轴的探针捕获 (按 axes 的稠密下标 arm) */
+    unsigned int  axis_first;      /* 本主站第 0 轴在全局配置 axes[] 中的下标 */
+    const double *setpoints;       /* 当前设定值 (用户单位，按本主站稠密下标) */
+    int           setpoints_fresh; /* 本周期是否采纳了对应周期的设定值帧 */
+    int           safe_state;      /* 连续错过截止时间，应输出安全值 */
+} master_member_t;
+
+typedef struct {
+    cycle_sched_stats_t sched;     /* 周期数、截止时间错过、跳过/补跑、安全态 */
+    uint64_t stale_frames;         /* 没有本周期设定值帧的周期数 */
+    uint32_t wake_latency_max_ns;  /* 实际醒来时刻相对时隙起点的最大延迟 */
+    uint32_t exec_max_ns;
+} master_stats_t;
+
+/*
+ * 周期回调，在 receive/process 之后、queue/send 之前调用。
+ * 为 NULL 时默认把新设定值写入处于 Operation Enabled 的轴；安全态下改为向全部
+ * CiA402 轴写 Quick Stop。
+ */
+typedef void (*master_cycle_fn)(master_member_t *m, uint64_t cycle, void *arg);
+
+typedef struct master_group master_group_t;
+
+/*
+ * 按配置拆分轴、逐个主站校验 PDO 映射，然后请求主站、配置从站并激活。
+ * buses 需覆盖 cfg->masters 中的每个主站。失败返回 -errno 并在 err 中给出原因。
+ * cfg 在 master_group_destroy() 之前必须保持有效。
+ */
+int master_group_create(const axis_config_table_t *cfg, const master_bus_t *buses,
+                        unsigned int n_buses, master_cycle_fn fn, void *arg,
+                        master_group_t **out, char *err, size_t err_len);
+
+/*
+ * 接入配置热加载 (config_reload.h)，须在 master_group_start() 之前调用；cr 以创建时的 cfg
+ * 为初始配置，并在 master_group_destroy() 之前保持有效。第 0 个主站线程每周期用全部主站的
+ * 使能位图调用 config_reload_sync()，切换后各主站从下一周期开始把新表的比例因子
+ * (axis_table_apply_scales()) 与模拟量参数 (analog_pipeline_apply()) 应用到本主站，
+ * 正常情况下所有主站在同一周期生效；某个主站尚未应用完上一版本时，新版本推迟同步。
+ */
+int master_group_set_reload(master_group_t *g, config_reload_t *cr);
+
+/*
+ * 为每个主站创建遥测段 (telemetry_shm.h)，须在 master_group_start() 之前调用。
+ * 段名为 "<name>.<主站编号>" (如 /ecat_telemetry.0)，字段为本主站每个 CiA402 轴的状态字
+ * (axis<id>.status_word，0x6041) 与实际位置 (axis<id>.actual_pos，0x6064，脉冲)；统计区为
+ * 本主站的周期间隔、执行时间与调度统计。周期线程在发送之后每 decimation 个周期发布一次快照。
+ * 成功返回 0，失败返回 -errno (已创建的段全部删除)。
+ */
+int master_group_set_telemetry(master_group_t *g, const char *name, unsigned int decimation);
+
+/* 确定共享 epoch 并启动全部周期线程；成功返回 0，失败返回 -errno */
+int master_group_start(master_group_t *g);
+
+/* 按共享时间基准计算的当前周期号 (任意线程可调用) */
+uint64_t master_group_cycle(const master_group_t *g);
+
+/*
+ * 发布第 cycle 周期的目标位置，pos 按全局配置 axes[] 下标索引 (长度 cfg->n_axes)。
+ * 只允许一个线程发布。每帧只能发布一次。
+ * 返回 0 表示已就绪；-ETIME 表示该周期已开始 (帧被判定过期)；
+ * -EAGAIN 表示超出环深度，或有主站落后、尚未取走该槽位中的旧帧 (稍后重试)；
+ * -EEXIST 表示该周期已发布过。
+ */
+int master_group_publish(master_group_t *g, uint64_t cycle, const double *pos);
+
+unsigned int master_group_count(const master_group_t *g);
+master_member_t *master_group_member(master_group_t *g, unsigned int i);
+int master_group_get_stats(const master_group_t *g, unsigned int i, master_stats_t *st);
+
+/* 请求所有主站退出安全态 (操作员复位) */
+void master_group_clear_safe(master_group_t *g);
+
+/* 诊断事件环 (非 RT 线程用 diag_ring_pop() 取出)；source 为主站编号 */
+diag_ring_t *master_group_diag(master_group_t *g);
+
+/* 第 i 个主站的总线健康计数器 (用 health_monitor_*_stats() 读取) */
+const health_monitor_t *master_group_health(const master_group_t *g, unsigned int i);
+
+/* 停止周期线程 (可重复调用) */
+void master_group_stop(master_group_t *g);
+
+/* 停止线程、释放主站与轴表 */
+void master_group_destroy(master_group_t *g);
+
+#endif /* MASTER_GROUP_H */
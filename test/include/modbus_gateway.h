@@ -0,0 +1,140 @@
+/*
+ * modbus_gateway.h
+ *
+ * 经 F2838x 从站 (test_all.h 的 slave 7) PDO 通道访问 Modbus 现场设备的网关。
+ *
+ * 应用线程提交异步读写请求；网关线程 (非 RT) 把请求合并/拆分为单条事务 (读最多 12 个、
+ * 写最多 11 个寄存器)，预先编好放入 SPSC 环交给周期任务。完成结果经第二个 SPSC 环返回网关
+ * 线程，由其回调应用。周期内不阻塞、不分配内存。
+ *
+ * 吞吐上限：该 PDO 协议只有一组命令/结果对象和一个 DoCommand 握手，上一条事务执行期间无法
+ * 发出下一条，不能做到流水线。预先编好事务只省去主机侧的组帧时间；每条事务至少占用约 3 个
+ * 周期 (发出命令、看到 DONE/ERROR 后结束握手、看到 IDLE 后才能发下一条) 再加上固件侧的
+ * Modbus 传输时间。需要更高吞吐时应合并为连续地址的大请求，而不是提交更多小请求。
+ *
+ * PDO 对象 (名称取自 ESI，doc/HCFAX3E copy.xml)：
+ *
+ *   RxPDO (主站 -> F2838x)
+ *     0x7001  DigitalOutputs        数字量输出，网关不使用
+ *     0x7002  ModbusDoCommand       1 执行命令，0 结束握手
+ *     0x7003  ModbusSlaveID         Modbus 站号
+ *     0x7004  ModbusFunction        功能码 (0x03/0x04/0x06/0x10)
+ *     0x7005  ModbusRegisterAddr    起始寄存器地址
+ *     0x7006  ModbusRegisterCount   寄存器数
+ *     0x7007 ~ 0x7011  ModbusRegisterData0 ~ 10   写数据 (最多 11 个)
+ *
+ *   TxPDO (F2838x -> 主站)
+ *     0x6006  ModbusState           MODBUS_GW_STATE_*
+ *     0x6007  ModbusErrorCode       0 成功；非 0 为 Modbus 异常码或固件错误
+ *     0x6008  ModbusRegistersCount  返回的寄存器数
+ *     0x6009 ~ 0x6014  ModbusRegisterData0 ~ 11   读结果 (最多 12 个)
+ *
+ * 握手：ModbusState 为 IDLE 时，主站在同一帧写入站号、功能码、地址、数量、数据并置
+ * DoCommand = 1；固件执行期间为 BUSY，结束后为 DONE 或 ERROR (ErrorCode 给出原因)；主站读取
+ * 结果后写 DoCommand = 0，固件回到 IDLE 后才能发下一条。超时的命令同样以 DoCommand = 0 结束，
+ * 启动时固件不在 IDLE 也先写 0 等它回到 IDLE，不会把残留结果当作新命令的结果。
+ */
+
+#ifndef MODBUS_GATEWAY_H
+#define MODBUS_GATEWAY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "axis_table.h"
+#include "ecrt.h"
+
+#define MODBUS_GW_READ_WINDOW  12   /* TxPDO 数据对象数：单条读事务的寄存器上限 */
+#define MODBUS_GW_WRITE_WINDOW 11   /* RxPDO 数据对象数：单条写事务的寄存器上限 */
+#define MODBUS_GW_SLOTS    4     /* 交给周期任务的事务数上限，其余请求留在队列中等待合并 */
+#define MODBUS_GW_MAX_REGS 1024  /* 单个请求的寄存器数上限 (自动拆分) */
+#define MODBUS_GW_DEFAULT_TIMEOUT_MS 500
+
+/*
+ * 0x6006 ModbusState 的取值。ESI 只给出对象名与类型，以下数值是按固件源码习惯做的假设，
+ * 尚未经 F2838x 固件确认；上线前需与固件核对，不一致时只需修改此处。
+ */
+enum {
+    MODBUS_GW_STATE_IDLE  = 0,
+    MODBUS_GW_STATE_BUSY  = 1,
+    MODBUS_GW_STATE_DONE  = 2,
+    MODBUS_GW_STATE_ERROR = 3,
+};
+
+enum {
+    MODBUS_FC_READ_HOLDING   = 0x03,
+    MODBUS_FC_READ_INPUT     = 0x04,
+    MODBUS_FC_WRITE_SINGLE   = 0x06,
+    MODBUS_FC_WRITE_MULTIPLE = 0x10,
+};
+
+typedef struct modbus_gw_req modbus_gw_req_t;
+typedef void (*modbus_gw_done_fn)(modbus_gw_req_t *req, void *arg);
+
+/*
+ * 请求由调用方分配，完成回调之前不得释放或修改。
+ * status：0 成功；>0 为 ModbusErrorCode (多段请求取第一个错误)；-EIO 为固件报 ERROR
+ * 但未给出错误码，或返回的寄存器数不足；-ETIMEDOUT 为周期任务侧超时；-ECANCELED 为网关已销毁。
+ */
+struct modbus_gw_req {
+    uint8_t           unit;
+    uint8_t           function;   /* MODBUS_FC_* */
+    uint16_t          addr;
+    uint16_t          count;      /* 1 ~ MODBUS_GW_MAX_REGS，写单个寄存器为 1 */
+    uint16_t         *regs;       /* 读：结果写入此处；写：数据来源 */
+    modbus_gw_done_fn done;       /* 在网关线程中调用 */
+    void             *arg;
+    int               status;
+
+    /* 以下由网关使用 */
+    uint16_t          scheduled;  /* 已编入事务的寄存器数 */
+    uint16_t          remaining;  /* 尚未完成的寄存器数 */
+    modbus_gw_req_t  *next;
+};
+
+typedef struct {
+    uint64_t requests;       /* 已完成的应用请求 */
+    uint64_t transactions;   /* 已完成的 PDO 事务 */
+    uint64_t registers;      /* 已传输的寄存器数 */
+    uint64_t merged;         /* 与前一请求合并进同一事务的次数 */
+    uint64_t errors;         /* 固件报错的事务 */
+    uint64_t timeouts;       /* 周期任务侧超时的事务 */
+} modbus_gw_stats_t;
+
+typedef struct modbus_gw modbus_gw_t;
+
+/*
+ * 只校验从站 sd 的 PDO 映射 (协议所需对象均为 16 位且方向正确)，不分配资源、不启动线程，
+ * 供离线校验使用。通过返回 0，否则返回 -EINVAL 并在 err 中给出原因。
+ */
+int modbus_gw_check(const axis_slave_desc_t *sd, char *err, size_t err_len);
+
+/*
+ * 按 modbus_gw_check() 校验 PDO 映射，创建网关并启动网关线程。
+ * cycle_us 为周期 (用于超时换算与网关线程轮询间隔)，timeout_ms 为 0 时取默认值。
+ * 失败返回 -errno 并在 err 中给出原因。
+ */
+int modbus_gw_create(const axis_slave_desc_t *sd, uint32_t cycle_us, uint32_t timeout_ms,
+                     modbus_gw_t **out, char *err, size_t err_len);
+
+/* 供 ecrt_domain_reg_pdo_entry_list() 使用的注册表 (以空项结尾) */
+const ec_pdo_entry_reg_t *modbus_gw_regs(const modbus_gw_t *gw);
+
+/* 主站激活后调用，预先计算 PDO 指针 */
+int modbus_gw_bind(modbus_gw_t *gw, uint8_t *domain_pd);
+
+/* 周期任务在 ecrt_domain_process() 之后调用：按 ModbusState 推进握手、收取结果、发出下一条事务 */
+void modbus_gw_cycle(modbus_gw_t *gw, uint64_t cycle);
+
+/* 提交异步请求 (任意线程)；参数无效返回 -EINVAL，网关已停止返回 -ESHUTDOWN */
+int modbus_gw_submit(modbus_gw_t *gw, modbus_gw_req_t *req);
+
+/* 同步封装：提交并等待完成，返回 req->status (req->done 被忽略) */
+int modbus_gw_transfer(modbus_gw_t *gw, modbus_gw_req_t *req);
+
+void modbus_gw_get_stats(const modbus_gw_t *gw, modbus_gw_stats_t *st);
+
+/* 停止网关线程，未完成的请求以 -ECANCELED 回调 */
+void modbus_gw_destroy(modbus_gw_t *gw);
+
+#endif /* MODBUS_GATEWAY_H */
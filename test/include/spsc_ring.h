@@ -0,0 +1,30 @@
+/*
+ * spsc_ring.h
+ *
+ * 单生产者 / 单消费者定长环，用于周期线程与非 RT 线程之间传递定长记录。
+ * 容量与元素大小在创建时确定，push / pop 只做一次 memcpy 与一次 release 存储，
+ * 不分配内存、不加锁、不做系统调用；环满时 push 失败，生产者永不阻塞。
+ */
+
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stddef.h>
+
+typedef struct spsc_ring spsc_ring_t;
+
+/* capacity 向上取整为 2 的幂；成功返回 0，失败返回 -errno */
+int spsc_ring_create(unsigned int capacity, size_t elem_size, spsc_ring_t **out);
+
+/* 写入一个元素 (仅生产者线程)；环满返回 -ENOSPC */
+int spsc_ring_push(spsc_ring_t *r, const void *elem);
+
+/* 取出最早的元素 (仅消费者线程)；有元素返回 1，环空返回 0 */
+int spsc_ring_pop(spsc_ring_t *r, void *elem);
+
+/* 当前元素数 (任意线程，仅作参考) */
+unsigned int spsc_ring_count(const spsc_ring_t *r);
+
+void spsc_ring_destroy(spsc_ring_t *r);
+
+#endif /* SPSC_RING_H */
@@ -0,0 +1,43 @@
+/*
+ * status_server.h
+ *
+ * 基于 epoll 的非阻塞 HTTP / WebSocket 状态服务 (默认端口 8088)
+ *
+ * 服务线程只通过 telemetry_reader_* 读取共享内存快照 (seqlock，无锁)，
+ * 与周期任务之间没有任何同步，客户端数量不会给总线周期带来抖动。
+ *
+ * 路由：
+ *   GET /status   当前快照 (JSON)
+ *   GET /layout   字段描述表 (JSON)
+ *   GET /ws       WebSocket，按 stream_period_ms 降采样、每 batch 个样本打包为一帧推送
+ *
+ * 每个客户端有独立的发送缓冲上限 (client_buf_limit)；超过上限的慢客户端直接断开，
+ * 不做无限缓存。
+ */
+
+#ifndef STATUS_SERVER_H
+#define STATUS_SERVER_H
+
+#include <stdint.h>
+
+#define STATUS_SERVER_DEFAULT_PORT 8088
+
+typedef struct {
+    uint16_t     port;              /* 监听端口，0 表示 STATUS_SERVER_DEFAULT_PORT */
+    const char  *shm_name;          /* 遥测段名，NULL 表示 TELEMETRY_SHM_DEFAULT_NAME */
+    unsigned int stream_period_ms;  /* WebSocket 采样间隔，0 表示 20ms */
+    unsigned int batch;             /* 每帧样本数，0 表示 5 */
+    unsigned int max_clients;       /* 最大连接数，0 表示 64 */
+    unsigned int client_buf_limit;  /* 单客户端待发送字节上限，0 表示 256KB */
+    int          cpu;               /* 服务线程绑定的 CPU，<0 表示不绑定 (应避开 RT 核) */
+} status_server_config_t;
+
+typedef struct status_server status_server_t;
+
+/* 启动服务线程；成功返回 0，失败返回 -errno */
+int status_server_start(const status_server_config_t *cfg, status_server_t **out);
+
+/* 停止服务线程并关闭所有连接 */
+void status_server_stop(status_server_t *srv);
+
+#endif /* STATUS_SERVER_H */
@@ -0,0 +1,132 @@
+/*
+ * telemetry_shm.h
+ *
+ * 实时遥测共享内存段 (POSIX shm + seqlock)
+ *
+ * 周期任务每 N 个周期把一份固定布局的快照写入共享内存，
+ * 外部进程 (看板、记录器、测试工具) 通过 telemetry_reader_* 读取一致快照：
+ * 读端只读映射、无系统调用、无锁，不会拖慢主站周期。
+ *
+ * 段布局 (版本 TELEMETRY_SHM_VERSION)：
+ *   telemetry_shm_header_t                 段头 (魔数/版本/尺寸/seqlock 序号)
+ *   telemetry_field_t[field_count]         字段描述表 (名称取自 PDO 布局)
+ *   payload (payload_offset 处)            telemetry_stats_t + uint32_t values[field_count]
+ */
+
+#ifndef TELEMETRY_SHM_H
+#define TELEMETRY_SHM_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#define TELEMETRY_SHM_DEFAULT_NAME "/ecat_telemetry"
+#define TELEMETRY_SHM_MAGIC        0x314D4C54u /* "TLM1" */
+#define TELEMETRY_SHM_VERSION      2u
+#define TELEMETRY_FIELD_NAME_LEN   32
+
+/* 字段原始类型，读端据此做符号扩展 */
+typedef enum {
+    TELEMETRY_U8 = 0,
+    TELEMETRY_S8,
+    TELEMETRY_U16,
+    TELEMETRY_S16,
+    TELEMETRY_U32,
+    TELEMETRY_S32,
+} telemetry_type_t;
+
+/* 共享内存中的字段描述 (自描述布局) */
+typedef struct {
+    char     name[TELEMETRY_FIELD_NAME_LEN];
+    uint16_t slave;    /* 从站总线位置 */
+    uint16_t index;    /* 对象字典索引，如 0x6041 */
+    uint8_t  subindex;
+    uint8_t  type;     /* telemetry_type_t */
+    uint16_t reserved;
+} telemetry_field_t;
+
+/* 周期统计，随每份快照一起发布 */
+typedef struct {
+    uint64_t cycle;          /* 周期计数 */
+    uint64_t timestamp_ns;   /* 快照时刻 (CLOCK_MONOTONIC) */
+    uint32_t period_ns;      /* 本周期实际间隔 */
+    uint32_t period_max_ns;  /* 启动以来最大间隔 */
+    uint32_t exec_ns;        /* 本周期执行耗时 */
+    uint32_t exec_max_ns;    /* 启动以来最大执行耗时 */
+    /* 调度统计 (cycle_sched.h)，没有调度器的写端填 0 */
+    uint64_t deadline_misses;
+    uint64_t skipped;        /* 丢弃的时隙数 */
+    uint64_t caught_up;      /* 补跑的周期数 */
+    uint32_t max_lateness_ns;
+    uint32_t safe_state;
+} telemetry_stats_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t segment_size;
+    uint32_t field_count;
+    uint32_t field_table_offset;
+    uint32_t payload_offset;
+    uint32_t payload_size;
+    uint32_t decimation;     /* 每 decimation 个周期发布一次 */
+    uint32_t cycle_us;
+    uint32_t reserved[7];
+    /* seqlock 序号：奇数表示写入中；独占一个 cache line 避免与描述区伪共享 */
+    _Alignas(64) _Atomic uint32_t seq;
+} telemetry_shm_header_t;
+
+/* 写端字段来源：pd_offset 指向 domain 注册时填写的偏移变量 */
+typedef struct {
+    const char         *name;
+    uint16_t            slave;
+    uint16_t            index;
+    uint8_t             subindex;
+    telemetry_type_t    type;
+    const unsigned int *pd_offset;
+} telemetry_source_t;
+
+typedef struct telemetry_shm telemetry_shm_t;
+typedef struct telemetry_reader telemetry_reader_t;
+
+/* --- 写端 (周期任务) --- */
+
+/*
+ * 创建、锁定 (mlock) 并初始化共享内存段；成功返回 0，失败返回 -errno。
+ * 同名旧段先被删除再独占创建，重启后总是新的段 (新 inode)，已 attach 的读端映射的旧段不变。
+ */
+int telemetry_shm_create(const char *name, const telemetry_source_t *sources,
+                         unsigned int n_sources, unsigned int decimation,
+                         unsigned int cycle_us, telemetry_shm_t **out);
+
+/* 周期调用：每 decimation 个周期从 domain 数据复制一次快照，不分配、不阻塞 */
+void telemetry_shm_publish(telemetry_shm_t *tlm, const uint8_t *domain_pd,
+                           const telemetry_stats_t *stats);
+
+/* 解除映射并删除共享内存段 */
+void telemetry_shm_destroy(telemetry_shm_t *tlm);
+
+/* --- 读端 (外部进程) --- */
+
+/*
+ * 只读映射已有段并校验魔数/版本，以及描述区偏移与字段数不超出段大小；字段数与段大小在此
+ * 缓存，之后的读取不再信任段头。成功返回 0，段不符返回 -EPROTO，其余失败返回 -errno
+ */
+int telemetry_reader_attach(const char *name, telemetry_reader_t **out);
+
+/* 字段描述表，生命周期与 reader 相同 */
+const telemetry_field_t *telemetry_reader_fields(const telemetry_reader_t *rd,
+                                                 unsigned int *count);
+
+/*
+ * 读取一份一致快照。values 至少容纳 field_count 个元素 (可为 NULL)。
+ * 写端持续写入导致多次重试仍失败时返回 -EAGAIN。
+ */
+int telemetry_reader_read(const telemetry_reader_t *rd, telemetry_stats_t *stats,
+                          uint32_t *values);
+
+/* 按字段类型把原始值转换为有符号整数 */
+int64_t telemetry_value_as_i64(const telemetry_field_t *field, uint32_t raw);
+
+void telemetry_reader_detach(telemetry_reader_t *rd);
+
+#endif /* TELEMETRY_SHM_H */
@@ -0,0 +1,83 @@
+/*
+ * touch_probe.h
+ *
+ * 伺服探针 (CiA402 Touch Probe 1) 的高速位置捕获。只作用于轴表中 0x60b8 / 0x60b9 / 0x60ba
+ * 均已映射的轴 (axis_table_t.probe_mask)，不经 SDO，轴运动中即可连续捕获。
+ *
+ * 应用线程用 touch_probe_arm() / touch_probe_disarm() 按轴位图提交请求，周期任务在下一周期
+ * 写 0x60b8：先写 0，待 0x60b9 的 bit0 (探针已使能) 清零后再写使能字 (探针 1 使能 +
+ * 上升沿采样，可选连续模式 / 零脉冲触发)。之后周期任务每周期只检查已使能轴的 0x60b9：
+ *
+ *   单次模式  bit1 (正沿已锁存) 0 -> 1 为一次新捕获，随后该轴自动解除，需重新 arm
+ *   连续模式  每次新锁存 bit1 翻转 (ETG.6010)，翻转即为一次新捕获
+ *
+ * 判定基准在驱动器确认探针关闭 (bit0 = 0) 时取得，并强制 bit1 = 0，因此不会误报旧锁存；
+ * 只要求当前周期 bit0 为 1，使能后第一个周期就到达的锁存同样计为一次捕获。bit0 为 0 的周期
+ * (驱动器尚未响应使能字) 不做判定，基准保持不变。
+ * 捕获 (锁存位置、换算后的用户单位、周期号与时隙起点) 写入 SPSC 环，
+ * 由一个消费线程用 touch_probe_pop() 取出。时间戳是检测到锁存的周期，
+ * 实际触发发生在该周期与上一周期之间，精确位置以驱动器锁存值为准。
+ */
+
+#ifndef TOUCH_PROBE_H
+#define TOUCH_PROBE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "axis_table.h"
+
+#define TOUCH_PROBE_DEFAULT_CAPACITY 256
+
+/* 0x60b8 Touch Probe Function (探针 1) */
+#define TOUCH_PROBE_FN_ENABLE     0x0001
+#define TOUCH_PROBE_FN_CONTINUOUS 0x0002
+#define TOUCH_PROBE_FN_ZERO_PULSE 0x0004   /* 以编码器零脉冲代替探针输入触发 */
+#define TOUCH_PROBE_FN_POS_EDGE   0x0010
+
+/* 0x60b9 Touch Probe Status (探针 1) */
+#define TOUCH_PROBE_ST_ENABLED    0x0001
+#define TOUCH_PROBE_ST_POS_STORED 0x0002
+
+typedef struct {
+    unsigned int capacity;     /* 捕获环容量，0 取 TOUCH_PROBE_DEFAULT_CAPACITY */
+    int          continuous;   /* 连续模式；否则每次 arm 只捕获一次 */
+    int          zero_pulse;   /* 以零脉冲为触发源 (回零、编码器标定) */
+} touch_probe_config_t;
+
+typedef struct {
+    unsigned int axis;         /* 稠密轴下标 */
+    int32_t      axis_id;
+    int32_t      raw;          /* 0x60ba 锁存值 (脉冲) */
+    double       position;     /* 用户单位 */
+    uint64_t     cycle;        /* 检测到锁存的周期 */
+    uint64_t     time_ns;      /* 该周期的时隙起点 (主机 CLOCK_MONOTONIC，不是 DC 时间) */
+} touch_probe_capture_t;
+
+typedef struct {
+    uint64_t captures;         /* 已写入环的捕获数 */
+    uint64_t dropped;          /* 环满丢弃的捕获数 */
+    uint64_t arms;             /* 已执行的 arm 次数 (按轴) */
+} touch_probe_stats_t;
+
+typedef struct touch_probe touch_probe_t;
+
+/* 为轴表 at 创建捕获服务 (at 须比服务存活更久)；cfg 可为 NULL 取默认值 */
+int touch_probe_create(const axis_table_t *at, const touch_probe_config_t *cfg,
+                       touch_probe_t **out);
+
+/* 请求 arm / disarm mask 中的轴 (任意线程，下一周期生效)，无探针的轴被忽略 */
+void touch_probe_arm(touch_probe_t *tp, const uint64_t *mask);
+void touch_probe_disarm(touch_probe_t *tp, const uint64_t *mask);
+
+/* 周期任务在 ecrt_domain_process() 之后调用 (轴表已 bind) */
+void touch_probe_cycle(touch_probe_t *tp, uint64_t cycle, uint64_t time_ns);
+
+/* 取出最早的捕获 (单个消费线程)；有数据返回 1，环空返回 0 */
+int touch_probe_pop(touch_probe_t *tp, touch_probe_capture_t *out);
+
+void touch_probe_get_stats(const touch_probe_t *tp, touch_probe_stats_t *st);
+
+void touch_probe_destroy(touch_probe_t *tp);
+
+#endif /* TOUCH_PROBE_H */
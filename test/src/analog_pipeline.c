@@ -0,0 +1,412 @@
+/*
+ * analog_pipeline.c
+ *
+ * 模拟量滤波流水线实现，接口说明见 analog_pipeline.h。
+ *
+ * 除 PDO 读取 (按偏移逐个取值) 与越限事件 (只在状态变化时逐通道处理) 外，各级都是
+ * 对 lanes 个 float 的定长循环，指针以 restrict 修饰、数组 64 字节对齐，
+ * 本文件在 CMakeLists.txt 中单独以 -O3 编译以启用自动向量化。
+ */
+
+#include "analog_pipeline.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MEDIAN_DEPTH 8                      /* 中值历史环 (>= ANALOG_MAX_MEDIAN，取 2 的幂) */
+#define AVG_DEPTH    ANALOG_MAX_AVG_WINDOW  /* 滑动平均历史环 */
+
+struct analog_pipeline {
+    unsigned int        n;
+    unsigned int        lanes;      /* n 向上取整到 ANALOG_LANES */
+    unsigned int        pos;        /* 历史环写位置 */
+    int                 primed;     /* 第一个样本已填满历史 */
+    diag_ring_t        *diag;
+    uint16_t            source;
+
+    /* PDO */
+    char              (*names)[ANALOG_NAME_LEN];
+    const uint8_t     **src;
+    uint8_t            *is_signed;
+    ec_pdo_entry_reg_t *regs;
+    unsigned int       *offsets;
+
+    /* 参数 (长度 lanes，填充通道为直通值) */
+    float              *gain;
+    float              *offset;
+    float              *median;     /* 1 / 3 / 5 */
+    float              *avg_coef;   /* [AVG_DEPTH][lanes]，年龄 < 窗口时为 1 / 窗口 */
+    float              *alpha;
+    float              *hi_set;     /* 无上限时为 +inf */
+    float              *hi_clear;
+    float              *lo_set;     /* 无下限时为 -inf */
+    float              *lo_clear;
+
+    /* 状态 */
+    float              *in;         /* 标定后的本周期输入 */
+    float              *raw_hist;   /* [MEDIAN_DEPTH][lanes] */
+    float              *med_hist;   /* [AVG_DEPTH][lanes] */
+    float              *avg;
+    float              *value;      /* IIR 输出，即通道值 */
+    uint8_t            *alarm;
+    uint8_t            *next;
+};
+
+static int pipeline_fail(char *err, size_t err_len, int ret, const char *fmt, ...)
+{
+    if (err && err_len) {
+        va_list ap;
+        va_start(ap, fmt);
+        vsnprintf(err, err_len, fmt, ap);
+        va_end(ap);
+    }
+    return ret;
+}
+
+/* 64 字节对齐并清零的数组，长度向上取整到整 cache line */
+static void *alloc_array(size_t n, size_t elem)
+{
+    size_t bytes = (n ? n : 1) * elem;
+    bytes = (bytes + 63) & ~(size_t)63;
+    void *p = aligned_alloc(64, bytes);
+    if (p)
+        memset(p, 0, bytes);
+    return p;
+}
+
+/* 在 PDO 映射中查找输入对象；找到返回 0 并给出子索引与位宽 */
+static int input_lookup(const ec_sync_info_t *syncs, uint16_t index, uint8_t *subindex,
+                        uint8_t *bits)
+{
+    for (const ec_sync_info_t *sm = syncs; sm && sm->index != 0xff; sm++) {
+        if (sm->dir != EC_DIR_INPUT)
+            continue;
+        for (unsigned int p = 0; p < sm->n_pdos; p++) {
+            const ec_pdo_info_t *pdo = &sm->pdos[p];
+            for (unsigned int e = 0; e < pdo->n_entries; e++) {
+                if (pdo->entries[e].index == index) {
+                    *subindex = pdo->entries[e].subindex;
+                    *bits = pdo->entries[e].bit_length;
+                    return 0;
+                }
+            }
+        }
+    }
+    return -1;
+}
+
+static void set_params(analog_pipeline_t *ap, const analog_config_t *ch)
+{
+    for (unsigned int i = 0; i < ap->n; i++) {
+        const analog_config_t *c = &ch[i];
+        ap->gain[i] = (float)c->gain;
+        ap->offset[i] = (float)c->offset;
+        ap->median[i] = (float)c->median;
+        ap->alpha[i] = (float)c->iir_alpha;
+        ap->hi_set[i] = c->has_high ? (float)c->high : INFINITY;
+        ap->hi_clear[i] = c->has_high ? (float)(c->high - c->hysteresis) : INFINITY;
+        ap->lo_set[i] = c->has_low ? (float)c->low : -INFINITY;
+        ap->lo_clear[i] = c->has_low ? (float)(c->low + c->hysteresis) : -INFINITY;
+        for (unsigned int a = 0; a < AVG_DEPTH; a++)
+            ap->avg_coef[a * ap->lanes + i] = a < c->avg_window ? 1.0f / c->avg_window : 0.0f;
+    }
+}
+
+int analog_pipeline_create(const analog_config_t *ch, unsigned int n,
+                           const axis_slave_desc_t *slaves, unsigned int n_slaves,
+                           diag_ring_t *diag, uint16_t source, analog_pipeline_t **out,
+                           char *err, size_t err_len)
+{
+    if ((n && !ch) || !out || (n_slaves && !slaves))
+        return -EINVAL;
+
+    analog_pipeline_t *ap = calloc(1, sizeof(*ap));
+    if (!ap)
+        return -ENOMEM;
+    unsigned int lanes = (n + ANALOG_LANES - 1) / ANALOG_LANES * ANALOG_LANES;
+    ap->n = n;
+    ap->lanes = lanes;
+    ap->diag = diag;
+    ap->source = source;
+
+    ap->names = calloc(n ? n : 1, sizeof(*ap->names));
+    ap->src = alloc_array(lanes, sizeof(*ap->src));
+    ap->is_signed = alloc_array(lanes, sizeof(*ap->is_signed));
+    ap->regs = calloc(n + 1, sizeof(*ap->regs));
+    ap->offsets = calloc(n ? n : 1, sizeof(*ap->offsets));
+    ap->gain = alloc_array(lanes, sizeof(float));
+    ap->offset = alloc_array(lanes, sizeof(float));
+    ap->median = alloc_array(lanes, sizeof(float));
+    ap->avg_coef = alloc_array((size_t)AVG_DEPTH * lanes, sizeof(float));
+    ap->alpha = alloc_array(lanes, sizeof(float));
+    ap->hi_set = alloc_array(lanes, sizeof(float));
+    ap->hi_clear = alloc_array(lanes, sizeof(float));
+    ap->lo_set = alloc_array(lanes, sizeof(float));
+    ap->lo_clear = alloc_array(lanes, sizeof(float));
+    ap->in = alloc_array(lanes, sizeof(float));
+    ap->raw_hist = alloc_array((size_t)MEDIAN_DEPTH * lanes, sizeof(float));
+    ap->med_hist = alloc_array((size_t)AVG_DEPTH * lanes, sizeof(float));
+    ap->avg = alloc_array(lanes, sizeof(float));
+    ap->value = alloc_array(lanes, sizeof(float));
+    ap->alarm = alloc_array(lanes, sizeof(uint8_t));
+    ap->next = alloc_array(lanes, sizeof(uint8_t));
+    if (!ap->names || !ap->src || !ap->is_signed || !ap->regs || !ap->offsets || !ap->gain ||
+        !ap->offset || !ap->median || !ap->avg_coef || !ap->alpha || !ap->hi_set ||
+        !ap->hi_clear || !ap->lo_set || !ap->lo_clear || !ap->in || !ap->raw_hist ||
+        !ap->med_hist || !ap->avg || !ap->value || !ap->alarm || !ap->next) {
+        analog_pipeline_destroy(ap);
+        return -ENOMEM;
+    }
+
+    for (unsigned int i = 0; i < n; i++) {
+        const analog_config_t *c = &ch[i];
+        const axis_slave_desc_t *sd = NULL;
+        for (unsigned int s = 0; s < n_slaves && !sd; s++) {
+            if (slaves[s].position == c->slave_id)
+                sd = &slaves[s];
+        }
+        uint8_t sub = 0, bits = 0;
+        int r = 0;
+        if (!sd)
+            r = pipeline_fail(err, err_len, -EINVAL, "analog '%s': slave %d not on bus",
+                              c->name, c->slave_id);
+        else if (input_lookup(sd->syncs, c->index, &sub, &bits))
+            r = pipeline_fail(err, err_len, -EINVAL,
+                              "analog '%s': 0x%04X not an input in PDO map of slave %d",
+                              c->name, c->index, c->slave_id);
+        else if (bits != 16)
+            r = pipeline_fail(err, err_len, -EINVAL, "analog '%s': 0x%04X is %u bits, expected 16",
+                              c->name, c->index, bits);
+        if (r) {
+            analog_pipeline_destroy(ap);
+            return r;
+        }
+        memcpy(ap->names[i], c->name, sizeof(ap->names[i]));
+        ap->is_signed[i] = c->is_signed;
+
+        ec_pdo_entry_reg_t *reg = &ap->regs[i];
+        reg->alias = sd->alias;
+        reg->position = sd->position;
+        reg->vendor_id = sd->vendor_id;
+        reg->product_code = sd->product_code;
+        reg->index = c->index;
+        reg->subindex = sub;
+        reg->offset = &ap->offsets[i];
+        reg->bit_position = NULL;
+    }
+
+    /* 填充通道：gain 为 0、无滤波、无上下限，输出恒为 0 */
+    for (unsigned int i = n; i < lanes; i++) {
+        ap->median[i] = 1.0f;
+        ap->avg_coef[i] = 1.0f;
+        ap->alpha[i] = 1.0f;
+        ap->hi_set[i] = ap->hi_clear[i] = INFINITY;
+        ap->lo_set[i] = ap->lo_clear[i] = -INFINITY;
+    }
+    set_params(ap, ch);
+    *out = ap;
+    return 0;
+}
+
+const ec_pdo_entry_reg_t *analog_pipeline_regs(const analog_pipeline_t *ap)
+{
+    return ap->regs;
+}
+
+int analog_pipeline_bind(analog_pipeline_t *ap, uint8_t *domain_pd)
+{
+    if (!ap || !domain_pd)
+        return -EINVAL;
+    for (unsigned int i = 0; i < ap->n; i++)
+        ap->src[i] = domain_pd + ap->offsets[i];
+    return 0;
+}
+
+/* --- 各级 (lanes 为 ANALOG_LANES 的整数倍) --- */
+
+static inline float fmin_(float a, float b) { return a < b ? a : b; }
+static inline float fmax_(float a, float b) { return a > b ? a : b; }
+static inline float med3(float a, float b, float c)
+{
+    return fmax_(fmin_(a, b), fmin_(fmax_(a, b), c));
+}
+
+static void stage_scale(unsigned int lanes, float *restrict in, const float *restrict gain,
+                        const float *restrict offset)
+{
+    for (unsigned int i = 0; i < lanes; i++)
+        in[i] = in[i] * gain[i] + offset[i];
+}
+
+/* h0 为最新样本，h1..h4 依次更早 */
+static void stage_median(unsigned int lanes, float *restrict out, const float *restrict sel,
+                         const float *restrict h0, const float *restrict h1,
+                         const float *restrict h2, const float *restrict h3,
+                         const float *restrict h4)
+{
+    for (unsigned int i = 0; i < lanes; i++) {
+        float m3 = med3(h0[i], h1[i], h2[i]);
+        /* 5 点中值 = med3(e, max(min(a,b), min(c,d)), min(max(a,b), max(c,d))) */
+        float lo = fmax_(fmin_(h1[i], h2[i]), fmin_(h3[i], h4[i]));
+        float hi = fmin_(fmax_(h1[i], h2[i]), fmax_(h3[i], h4[i]));
+        float m5 = med3(h0[i], lo, hi);
+        out[i] = sel[i] == 5.0f ? m5 : (sel[i] == 3.0f ? m3 : h0[i]);
+    }
+}
+
+static void stage_mac(unsigned int lanes, float *restrict acc, const float *restrict coef,
+                      const float *restrict h)
+{
+    for (unsigned int i = 0; i < lanes; i++)
+        acc[i] += coef[i] * h[i];
+}
+
+static void stage_iir(unsigned int lanes, float *restrict y, const float *restrict x,
+                      const float *restrict alpha)
+{
+    for (unsigned int i = 0; i < lanes; i++)
+        y[i] += alpha[i] * (x[i] - y[i]);
+}
+
+/* 返回非 0 表示有通道的越限状态发生变化 */
+static unsigned int stage_limits(const analog_pipeline_t *ap)
+{
+    const float *restrict y = ap->value;
+    const float *restrict hs = ap->hi_set, *restrict hc = ap->hi_clear;
+    const float *restrict ls = ap->lo_set, *restrict lc = ap->lo_clear;
+    const uint8_t *restrict old = ap->alarm;
+    uint8_t *restrict next = ap->next;
+    unsigned int lanes = ap->lanes, diff = 0;
+    for (unsigned int i = 0; i < lanes; i++) {
+        /* 全部用按位运算，循环内无分支 */
+        unsigned int o = old[i];
+        unsigned int h = (unsigned int)(y[i] > hs[i]) | (o & (unsigned int)(y[i] > hc[i]));
+        unsigned int l = (unsigned int)(y[i] < ls[i]) | ((o >> 1) & (unsigned int)(y[i] < lc[i]));
+        unsigned int x = h | l << 1;
+        next[i] = (uint8_t)x;
+        diff |= x ^ o;
+    }
+    return diff;
+}
+
+void analog_pipeline_cycle(analog_pipeline_t *ap, uint64_t cycle)
+{
+    unsigned int lanes = ap->lanes;
+    if (!ap->n || !ap->src[0])
+        return;
+
+    for (unsigned int i = 0; i < ap->n; i++) {
+        uint16_t raw = EC_READ_U16(ap->src[i]);
+        ap->in[i] = ap->is_signed[i] ? (float)(int16_t)raw : (float)raw;
+    }
+    stage_scale(lanes, ap->in, ap->gain, ap->offset);
+
+    if (!ap->primed) {
+        /* 用第一个样本填满历史，避免启动时从 0 爬升 */
+        for (unsigned int a = 0; a < MEDIAN_DEPTH; a++)
+            memcpy(ap->raw_hist + a * lanes, ap->in, lanes * sizeof(float));
+        for (unsigned int a = 0; a < AVG_DEPTH; a++)
+            memcpy(ap->med_hist + a * lanes, ap->in, lanes * sizeof(float));
+        memcpy(ap->value, ap->in, lanes * sizeof(float));
+        ap->primed = 1;
+    }
+
+    unsigned int p = ++ap->pos;
+#define RAW(age) (ap->raw_hist + (size_t)((p - (age)) & (MEDIAN_DEPTH - 1)) * lanes)
+#define MED(age) (ap->med_hist + (size_t)((p - (age)) & (AVG_DEPTH - 1)) * lanes)
+    memcpy(RAW(0), ap->in, lanes * sizeof(float));
+    stage_median(lanes, MED(0), ap->median, RAW(0), RAW(1), RAW(2), RAW(3), RAW(4));
+
+    memset(ap->avg, 0, lanes * sizeof(float));
+    for (unsigned int a = 0; a < AVG_DEPTH; a++)
+        stage_mac(lanes, ap->avg, ap->avg_coef + (size_t)a * lanes, MED(a));
+#undef RAW
+#undef MED
+
+    stage_iir(lanes, ap->value, ap->avg, ap->alpha);
+
+    if (!stage_limits(ap))
+        return;
+    for (unsigned int i = 0; i < ap->n; i++) {
+        uint8_t o = ap->alarm[i], x = ap->next[i];
+        if (o == x)
+            continue;
+        int64_t v = (int64_t)((double)ap->value[i] * 1000.0);
+        if ((x & ANALOG_ALARM_HIGH) && !(o & ANALOG_ALARM_HIGH))
+            diag_ring_push_detail(ap->diag, DIAG_ANALOG_HIGH, ap->source, i, cycle, v);
+        if ((x & ANALOG_ALARM_LOW) && !(o & ANALOG_ALARM_LOW))
+            diag_ring_push_detail(ap->diag, DIAG_ANALOG_LOW, ap->source, i, cycle, v);
+        if (!x)
+            diag_ring_push_detail(ap->diag, DIAG_ANALOG_NORMAL, ap->source, i, cycle, v);
+        ap->alarm[i] = x;
+    }
+}
+
+int analog_pipeline_apply(analog_pipeline_t *ap, const analog_config_t *ch, unsigned int n)
+{
+    if (n != ap->n)
+        return -EINVAL;
+    for (unsigned int i = 0; i < n; i++) {
+        if (ch[i].index != ap->regs[i].index || ch[i].slave_id != ap->regs[i].position ||
+            ch[i].is_signed != ap->is_signed[i])
+            return -EINVAL;
+    }
+    set_params(ap, ch);
+    return 0;
+}
+
+unsigned int analog_pipeline_count(const analog_pipeline_t *ap)
+{
+    return ap->n;
+}
+
+int analog_pipeline_find(const analog_pipeline_t *ap, const char *name)
+{
+    for (unsigned int i = 0; i < ap->n; i++) {
+        if (!strcmp(ap->names[i], name))
+            return (int)i;
+    }
+    return -1;
+}
+
+const float *analog_pipeline_values(const analog_pipeline_t *ap)
+{
+    return ap->value;
+}
+
+unsigned int analog_pipeline_alarm(const analog_pipeline_t *ap, unsigned int i)
+{
+    return i < ap->n ? ap->alarm[i] : 0;
+}
+
+void analog_pipeline_destroy(analog_pipeline_t *ap)
+{
+    if (!ap)
+        return;
+    free(ap->names);
+    free(ap->src);
+    free(ap->is_signed);
+    free(ap->regs);
+    free(ap->offsets);
+    free(ap->gain);
+    free(ap->offset);
+    free(ap->median);
+    free(ap->avg_coef);
+    free(ap->alpha);
+    free(ap->hi_set);
+    free(ap->hi_clear);
+    free(ap->lo_set);
+    free(ap->lo_clear);
+    free(ap->in);
+    free(ap->raw_hist);
+    free(ap->med_hist);
+    free(ap->avg);
+    free(ap->value);
+    free(ap->alarm);
+    free(ap->next);
+    free(ap);
+}
@@ -0,0 +1,962 @@
+/*
+ * axis_config.c
+ *
+ * 配置文件的单遍解析：递归下降直接把 JSON 值写入 axis_config_table_t，
+ * 未识别的键整体跳过。接口说明见 axis_config.h。
+ */
+
+#include "axis_config.h"
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    const char *p;
+    const char *end;
+    int         line;
+    char       *err;
+    size_t      err_len;
+} json_parser_t;
+
+static int parse_fail(json_parser_t *jp, const char *fmt, ...)
+{
+    if (jp->err && jp->err_len) {
+        int n = snprintf(jp->err, jp->err_len, "line %d: ", jp->line);
+        if (n >= 0 && (size_t)n < jp->err_len) {
+            va_list ap;
+            va_start(ap, fmt);
+            vsnprintf(jp->err + n, jp->err_len - (size_t)n, fmt, ap);
+            va_end(ap);
+        }
+    }
+    return -EINVAL;
+}
+
+static void skip_ws(json_parser_t *jp)
+{
+    while (jp->p < jp->end) {
+        char c = *jp->p;
+        if (c == '\n')
+            jp->line++;
+        else if (c != ' ' && c != '\t' && c != '\r')
+            return;
+        jp->p++;
+    }
+}
+
+static int peek(json_parser_t *jp)
+{
+    skip_ws(jp);
+    return jp->p < jp->end ? (unsigned char)*jp->p : -1;
+}
+
+static int expect(json_parser_t *jp, char c)
+{
+    if (peek(jp) != c)
+        return parse_fail(jp, "expected '%c'", c);
+    jp->p++;
+    return 0;
+}
+
+/* 解析字符串；buf 为 NULL 时仅跳过。超长字符串视为错误 */
+static int parse_string(json_parser_t *jp, char *buf, size_t len)
+{
+    if (expect(jp, '"'))
+        return -EINVAL;
+    size_t n = 0;
+    while (jp->p < jp->end && *jp->p != '"') {
+        char c = *jp->p++;
+        if (c == '\n')
+            return parse_fail(jp, "unterminated string");
+        if (c == '\\') {
+            if (jp->p >= jp->end)
+                break;
+            c = *jp->p++;
+            switch (c) {
+            case 'n': c = '\n'; break;
+            case 't': c = '\t'; break;
+            case 'r': c = '\r'; break;
+            case 'b': c = '\b'; break;
+            case 'f': c = '\f'; break;
+            case 'u':
+                /* 配置中不应出现非 ASCII 转义，按 '?' 处理 */
+                if (jp->end - jp->p < 4)
+                    return parse_fail(jp, "bad \\u escape");
+                jp->p += 4;
+                c = '?';
+                break;
+            default: break;
+            }
+        }
+        if (buf) {
+            if (n + 1 >= len)
+                return parse_fail(jp, "string too long");
+            buf[n] = c;
+        }
+        n++;
+    }
+    if (jp->p >= jp->end)
+        return parse_fail(jp, "unterminated string");
+    jp->p++;
+    if (buf)
+        buf[n] = '\0';
+    return 0;
+}
+
+static int parse_number(json_parser_t *jp, double *v)
+{
+    skip_ws(jp);
+    char tmp[64];
+    size_t n = 0;
+    while (jp->p + n < jp->end && n < sizeof(tmp) - 1 &&
+           strchr("+-0123456789.eE", jp->p[n]))
+        n++;
+    if (!n)
+        return parse_fail(jp, "expected number");
+    memcpy(tmp, jp->p, n);
+    tmp[n] = '\0';
+    char *endp;
+    *v = strtod(tmp, &endp);
+    if (endp != tmp + n)
+        return parse_fail(jp, "malformed number '%s'", tmp);
+    jp->p += n;
+    return 0;
+}
+
+static int parse_int(json_parser_t *jp, const char *key, long min, long max, long *v)
+{
+    double d;
+    if (parse_number(jp, &d))
+        return -EINVAL;
+    if (d != (double)(long)d)
+        return parse_fail(jp, "'%s' must be an integer", key);
+    if (d < (double)min || d > (double)max)
+        return parse_fail(jp, "'%s' = %ld out of range [%ld, %ld]", key, (long)d, min, max);
+    *v = (long)d;
+    return 0;
+}
+
+/* 对象索引：数字或 "0x6002" 形式的字符串 */
+static int parse_index(json_parser_t *jp, const char *key, uint16_t *v)
+{
+    if (peek(jp) != '"') {
+        long l;
+        if (parse_int(jp, key, 0, 0xFFFF, &l))
+            return -EINVAL;
+        *v = (uint16_t)l;
+        return 0;
+    }
+    char buf[16];
+    if (parse_string(jp, buf, sizeof(buf)))
+        return -EINVAL;
+    char *endp;
+    unsigned long l = strtoul(buf, &endp, 0);
+    if (!buf[0] || *endp || l > 0xFFFF)
+        return parse_fail(jp, "'%s' must be an object index such as \"0x6002\"", key);
+    *v = (uint16_t)l;
+    return 0;
+}
+
+static int parse_bool(json_parser_t *jp, const char *key, uint8_t *v)
+{
+    skip_ws(jp);
+    if (jp->end - jp->p >= 4 && !strncmp(jp->p, "true", 4)) {
+        jp->p += 4;
+        *v = 1;
+        return 0;
+    }
+    if (jp->end - jp->p >= 5 && !strncmp(jp->p, "false", 5)) {
+        jp->p += 5;
+        *v = 0;
+        return 0;
+    }
+    return parse_fail(jp, "'%s' must be true or false", key);
+}
+
+static int skip_value(json_parser_t *jp);
+
+static int skip_container(json_parser_t *jp, char open, char close)
+{
+    if (expect(jp, open))
+        return -EINVAL;
+    if (peek(jp) == close) {
+        jp->p++;
+        return 0;
+    }
+    for (;;) {
+        if (open == '{') {
+            if (parse_string(jp, NULL, 0) || expect(jp, ':'))
+                return -EINVAL;
+        }
+        if (skip_value(jp))
+            return -EINVAL;
+        int c = peek(jp);
+        jp->p++;
+        if (c == close)
+            return 0;
+        if (c != ',')
+            return parse_fail(jp, "expected ',' or '%c'", close);
+    }
+}
+
+static int skip_value(json_parser_t *jp)
+{
+    int c = peek(jp);
+    if (c == '"')
+        return parse_string(jp, NULL, 0);
+    if (c == '{')
+        return skip_container(jp, '{', '}');
+    if (c == '[')
+        return skip_container(jp, '[', ']');
+    static const char *const words[] = {"true", "false", "null"};
+    for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); i++) {
+        size_t wl = strlen(words[i]);
+        if ((size_t)(jp->end - jp->p) >= wl && !strncmp(jp->p, words[i], wl)) {
+            jp->p += wl;
+            return 0;
+        }
+    }
+    double d;
+    return parse_number(jp, &d);
+}
+
+/*
+ * 遍历对象的键值对：每个键回调一次 on_key，回调负责消费值。
+ * 回调返回 1 表示未识别该键，由这里跳过。
+ */
+typedef int (*key_handler_t)(json_parser_t *jp, const char *key, void *ctx);
+
+static int parse_object(json_parser_t *jp, key_handler_t on_key, void *ctx)
+{
+    if (expect(jp, '{'))
+        return -EINVAL;
+    if (peek(jp) == '}') {
+        jp->p++;
+        return 0;
+    }
+    for (;;) {
+        char key[64];
+        if (parse_string(jp, key, sizeof(key)) || expect(jp, ':'))
+            return -EINVAL;
+        int r = on_key(jp, key, ctx);
+        if (r < 0)
+            return r;
+        if (r > 0 && skip_value(jp))
+            return -EINVAL;
+        int c = peek(jp);
+        jp->p++;
+        if (c == '}')
+            return 0;
+        if (c != ',')
+            return parse_fail(jp, "expected ',' or '}'");
+    }
+}
+
+/* 遍历数组元素，每个元素回调一次 on_item */
+typedef int (*item_handler_t)(json_parser_t *jp, void *ctx);
+
+static int parse_array(json_parser_t *jp, item_handler_t on_item, void *ctx)
+{
+    if (expect(jp, '['))
+        return -EINVAL;
+    if (peek(jp) == ']') {
+        jp->p++;
+        return 0;
+    }
+    for (;;) {
+        int r = on_item(jp, ctx);
+        if (r)
+            return r;
+        int c = peek(jp);
+        jp->p++;
+        if (c == ']')
+            return 0;
+        if (c != ',')
+            return parse_fail(jp, "expected ',' or ']'");
+    }
+}
+
+/* ---------------------------------------------------------------------- */
+
+typedef struct {
+    axis_config_table_t *tbl;
+    slave_config_t      *slave;
+    axis_config_t       *axis;
+    analog_config_t     *analog;
+    int                  has_id;
+    master_config_t     *master;
+    unsigned int         slaves_cap;
+    unsigned int         axes_cap;
+    unsigned int         analog_cap;
+    unsigned int         di_cap;
+    uint64_t             seen_axes[(AXIS_CONFIG_MAX_AXIS_ID + 64) / 64];  /* 已出现的 axis_id */
+} parse_ctx_t;
+
+/* 按需扩容 (容量翻倍)，保证 *arr 至少还能容纳一个元素 */
+static int grow(void **arr, unsigned int *cap, unsigned int n, size_t elem)
+{
+    if (n < *cap)
+        return 0;
+    unsigned int ncap = *cap ? *cap * 2 : 16;
+    void *p = realloc(*arr, (size_t)ncap * elem);
+    if (!p)
+        return -ENOMEM;
+    *arr = p;
+    *cap = ncap;
+    return 0;
+}
+
+static int on_master_key(json_parser_t *jp, const char *key, void *ctx)
+{
+    parse_ctx_t *pc = ctx;
+    long v;
+
+    if (!strcmp(key, "index")) {
+        if (parse_int(jp, key, 0, 255, &v))
+            return -EINVAL;
+        pc->master->index = (int)v;
+        pc->has_id = 1;
+        return 0;
+    }
+    if (!strcmp(key, "cpu")) {
+        if (parse_int(jp, key, -1, 1023, &v))
+            return -EINVAL;
+        pc->master->cpu = (int)v;
+        return 0;
+    }
+    return 1;
+}
+
+static int on_master_item(json_parser_t *jp, void *ctx)
+{
+    parse_ctx_t *pc = ctx;
+    axis_config_table_t *tbl = pc->tbl;
+    if (tbl->n_masters >= AXIS_CONFIG_MAX_MASTERS)
+        return parse_fail(jp, "too many masters (max %d)", AXIS_CONFIG_MAX_MASTERS);
+
+    master_config_t *m = &tbl->masters[tbl->n_masters];
+    m->index = 0;
+    m->cpu = -1;
+    pc->master = m;
+    pc->has_id = 0;
+    if (parse_object(jp, on_master_key, pc))
+        return -EINVAL;
+    if (!pc->has_id)
+        return parse_fail(jp, "master without 'index'");
+    for (unsigned int i = 0; i < tbl->n_masters; i++) {
+        if (tbl->masters[i].index == m->index)
+            return parse_fail(jp, "duplicate master index %d", m->index);
+    }
+    tbl->n_masters++;
+    return 0;
+}
+
+static int on_network_key(json_parser_t *jp, const char *key, void *ctx)
+{
+    parse_ctx_t *pc = ctx;
+    long v;
+
+    if (!strcmp(key, "masters")) {
+        pc->tbl->n_masters = 0;
+        return parse_array(jp, on_master_item, pc);
+    }
+    if (!strcmp(key, "eni_path"))
+        return parse_string(jp, pc->tbl->eni_path, sizeof(pc->tbl->eni_path));
+    if (!strcmp(key, "cycle_us")) {
+        if (parse_int(jp, key, 100, 1000000, &v))
+            return -EINVAL;
+        pc->tbl->cycle_us = (uint32_t)v;
+        return 0;
+    }
+    if (!strcmp(key, "overrun_policy")) {
+        char policy[16];
+        if (parse_string(jp, policy, sizeof(policy)))
+            return -EINVAL;
+        if (!strcmp(policy, "skip"))
+            pc->tbl->overrun_policy = CYCLE_OVERRUN_SKIP;
+        else if (!strcmp(policy, "catchup"))
+            pc->tbl->overrun_policy = CYCLE_OVERRUN_CATCHUP;
+        else
+            return parse_fail(jp, "'overrun_policy' must be \"skip\" or \"catchup\"");
+        return 0;
+    }
+    if (!strcmp(key, "max_catchup")) {
+        if (parse_int(jp, key, 1, 1000, &v))
+            return -EINVAL;
+        pc->tbl->max_catchup = (uint32_t)v;
+        return 0;
+    }
+    if (!strcmp(key, "safe_after_misses")) {
+        if (parse_int(jp, key, 0, 1000000, &v))
+            return -EINVAL;
+        pc->tbl->safe_after_misses = (uint32_t)v;
+        return 0;
+    }
+    return 1;
+}
+
+static int on_axis_key(json_parser_t *jp, const char *key, void *ctx)
+{
+    parse_ctx_t *pc = ctx;
+    axis_config_t *ax = pc->axis;
+    long v;
+    double d;
+
+    if (!strcmp(key, "axis_id")) {
+        if (parse_int(jp, key, 0, AXIS_CONFIG_MAX_AXIS_ID, &v))
+            return -EINVAL;
+        ax->axis_id = (int)v;
+        pc->has_id = 1;
+        return 0;
+    }
+    if (!strcmp(key, "offset")) {
+        if (parse_int(jp, key, 0, 0xFFFF, &v))
+            return -EINVAL;
+        ax->offset = (uint16_t)v;
+        return 0;
+    }
+    if (!strcmp(key, "encoder_res")) {
+        if (parse_int(jp, key, 1, 0x7FFFFFFF, &v))
+            return -EINVAL;
+        ax->encoder_res = (uint32_t)v;
+        return 0;
+    }
+    if (!strcmp(key, "gear_ratio")) {
+        if (parse_number(jp, &d))
+            return -EINVAL;
+        if (!(d > 0.0))
+            return parse_fail(jp, "'gear_ratio' must be positive");
+        ax->gear_ratio = d;
+        return 0;
+    }
+    if (!strcmp(key, "unit_per_rev")) {
+        if (parse_number(jp, &d))
+            return -EINVAL;
+        if (d < 0.0)
+            return parse_fail(jp, "'unit_per_rev' must not be negative");
+        ax->unit_per_rev = d;
+        return 0;
+    }
+    return 1;
+}
+
+static int on_axis_item(json_parser_t *jp, void *ctx)
+{
+    parse_ctx_t *pc = ctx;
+    axis_config_table_t *tbl = pc->tbl;
+    if (grow((void **)&tbl->axes, &pc->axes_cap, tbl->n_axes, sizeof(*tbl->axes)))
+        return -ENOMEM;
+
+    axis_config_t *ax = &tbl->axes[tbl->n_axes];
+    memset(ax, 0, sizeof(*ax));
+    ax->encoder_res = AXIS_DEFAULT_ENCODER_RES;
+    ax->gear_ratio = 1.0;
+    ax->unit_per_rev = 1.0;
+    pc->axis = ax;
+    pc->has_id = 0;
+
+    if (parse_object(jp, on_axis_key, pc))
+        return -EINVAL;
+    if (!pc->has_id)
+        return parse_fail(jp, "axis without 'axis_id'");
+    uint64_t bit = 1ull << (ax->axis_id & 63);
+    if (pc->seen_axes[ax->axis_id >> 6] & bit)
+        return parse_fail(jp, "duplicate axis_id %d", ax->axis_id);
+    pc->seen_axes[ax->axis_id >> 6] |= bit;
+
+    /* unit_per_rev 为 0 时按 1.0 处理 (用户单位 = 负载圈数) */
+    double upr = ax->unit_per_rev > 0.0 ? ax->unit_per_rev : 1.0;
+    ax->scale = (double)ax->encoder_res * ax->gear_ratio / upr;
+    tbl->n_axes++;
+    return 0;
+}
+
+static int on_analog_key(json_parser_t *jp, const char *key, void *ctx)
+{
+    parse_ctx_t *pc = ctx;
+    analog_config_t *an = pc->analog;
+    long v;
+    double d;
+
+    if (!strcmp(key, "name"))
+        return parse_string(jp, an->name, sizeof(an->name));
+    if (!strcmp(key, "index")) {
+        if (parse_index(jp, key, &an->index))
+            return -EINVAL;
+        pc->has_id = 1;
+        return 0;
+    }
+    if (!strcmp(key, "signed"))
+        return parse_bool(jp, key, &an->is_signed);
+    if (!strcmp(key, "gain"))
+        return parse_number(jp, &an->gain);
+    if (!strcmp(key, "offset"))
+        return parse_number(jp, &an->offset);
+    if (!strcmp(key, "median")) {
+        if (parse_int(jp, key, 1, ANALOG_MAX_MEDIAN, &v))
+            return -EINVAL;
+        if (!(v & 1))
+            return parse_fail(jp, "'median' must be 1, 3 or 5");
+        an->median = (uint8_t)v;
+        return 0;
+    }
+    if (!strcmp(key, "avg_window")) {
+        if (parse_int(jp, key, 1, ANALOG_MAX_AVG_WINDOW, &v))
+            return -EINVAL;
+        an->avg_window = (uint8_t)v;
+        return 0;
+    }
+    if (!strcmp(key, "iir_alpha")) {
+        if (parse_number(jp, &d))
+            return -EINVAL;
+        if (!(d > 0.0 && d <= 1.0))
+            return parse_fail(jp, "'iir_alpha' must be in (0, 1]");
+        an->iir_alpha = d;
+        return 0;
+    }
+    if (!strcmp(key, "high")) {
+        an->has_high = 1;
+        return parse_number(jp, &an->high);
+    }
+    if (!strcmp(key, "low")) {
+        an->has_low = 1;
+        return parse_number(jp, &an->low);
+    }
+    if (!strcmp(key, "hysteresis")) {
+        if (parse_number(jp, &d))
+            return -EINVAL;
+        if (d < 0.0)
+            return parse_fail(jp, "'hysteresis' must not be negative");
+        an->hysteresis = d;
+        return 0;
+    }
+    return 1;
+}
+
+static int on_analog_item(json_parser_t *jp, void *ctx)
+{
+    parse_ctx_t *pc = ctx;
+    axis_config_table_t *tbl = pc->tbl;
+    if (grow((void **)&tbl->analog, &pc->analog_cap, tbl->n_analog, sizeof(*tbl->analog)))
+        return -ENOMEM;
+
+    analog_config_t *an = &tbl->analog[tbl->n_analog];
+    memset(an, 0, sizeof(*an));
+    an->median = 1;
+    an->avg_window = 1;
+    an->gain = 1.0;
+    an->iir_alpha = 1.0;
+    pc->analog = an;
+    pc->has_id = 0;
+
+    if (parse_object(jp, on_analog_key, pc))
+        return -EINVAL;
+    if (!pc->has_id)
+        return parse_fail(jp, "analog channel without 'index'");
+    if (an->has_high && an->has_low && an->low >= an->high)
+        return parse_fail(jp, "analog 0x%04X: 'low' must be below 'high'", an->index);
+    tbl->n_analog++;
+    return 0;
+}
+
+static int on_di_item(json_parser_t *jp, void *ctx)
+{
+    parse_ctx_t *pc = ctx;
+    axis_config_table_t *tbl = pc->tbl;
+    if (grow((void **)&tbl->di, &pc->di_cap, tbl->n_di, sizeof(*tbl->di)))
+        return -ENOMEM;
+
+    di_config_t *di = &tbl->di[tbl->n_di];
+    memset(di, 0, sizeof(*di));
+    if (parse_index(jp, "digital_inputs", &di->index))
+        return -EINVAL;
+    tbl->n_di++;
+    return 0;
+}
+
+static int on_slave_key(json_parser_t *jp, const char *key, void *ctx)
+{
+    parse_ctx_t *pc = ctx;
+    slave_config_t *sl = pc->slave;
+    long v;
+
+    if (!strcmp(key, "id")) {
+        if (parse_int(jp, key, 0, 0xFFFF, &v))
+            return -EINVAL;
+        sl->id = (int)v;
+        pc->has_id = 1;
+        return 0;
+    }
+    if (!strcmp(key, "master")) {
+        if (parse_int(jp, key, 0, 255, &v))
+            return -EINVAL;
+        sl->master = (int)v;
+        return 0;
+    }
+    if (!strcmp(key, "type")) {
+        char type[32];
+        if (parse_string(jp, type, sizeof(type)))
+            return -EINVAL;
+        sl->type = strcmp(type, "io") ? SLAVE_TYPE_CIA402 : SLAVE_TYPE_IO;
+        return 0;
+    }
+    if (!strcmp(key, "digital_inputs"))
+        return parse_array(jp, on_di_item, pc);
+    if (!strcmp(key, "modbus_gateway"))
+        return parse_bool(jp, key, &sl->modbus_gateway);
+    if (!strcmp(key, "axes")) {
+        int has_id = pc->has_id;
+        int r = parse_array(jp, on_axis_item, pc);
+        pc->has_id = has_id;
+        return r;
+    }
+    if (!strcmp(key, "analog")) {
+        int has_id = pc->has_id;
+        int r = parse_array(jp, on_analog_item, pc);
+        pc->has_id = has_id;
+        return r;
+    }
+    return 1;
+}
+
+static int on_slave_item(json_parser_t *jp, void *ctx)
+{
+    parse_ctx_t *pc = ctx;
+    axis_config_table_t *tbl = pc->tbl;
+    if (grow((void **)&tbl->slaves, &pc->slaves_cap, tbl->n_slaves, sizeof(*tbl->slaves)))
+        return -ENOMEM;
+
+    slave_config_t *sl = &tbl->slaves[tbl->n_slaves];
+    memset(sl, 0, sizeof(*sl));
+    pc->slave = sl;
+    pc->has_id = 0;
+    unsigned int first_axis = tbl->n_axes;
+    unsigned int first_analog = tbl->n_analog;
+    unsigned int first_di = tbl->n_di;
+    if (parse_object(jp, on_slave_key, pc))
+        return -EINVAL;
+    if (!pc->has_id)
+        return parse_fail(jp, "slave without 'id'");
+    for (unsigned int i = 0; i < tbl->n_slaves; i++) {
+        if (tbl->slaves[i].id == sl->id && tbl->slaves[i].master == sl->master)
+            return parse_fail(jp, "duplicate slave id %d on master %d", sl->id, sl->master);
+        if (sl->modbus_gateway && tbl->slaves[i].modbus_gateway &&
+            tbl->slaves[i].master == sl->master)
+            return parse_fail(jp, "more than one modbus_gateway slave on master %d", sl->master);
+    }
+    /* 键顺序不限：对象结束后再回填所属从站 */
+    for (unsigned int i = first_axis; i < tbl->n_axes; i++) {
+        tbl->axes[i].slave_id = sl->id;
+        tbl->axes[i].master = sl->master;
+        tbl->axes[i].type = sl->type;
+    }
+    for (unsigned int i = first_analog; i < tbl->n_analog; i++) {
+        analog_config_t *an = &tbl->analog[i];
+        for (unsigned int j = first_analog; j < i; j++) {
+            if (tbl->analog[j].index == an->index)
+                return parse_fail(jp, "duplicate analog index 0x%04X on slave %d", an->index,
+                                  sl->id);
+        }
+        an->slave_id = sl->id;
+        an->master = sl->master;
+        if (!an->name[0])
+            snprintf(an->name, sizeof(an->name), "%d:0x%04X", sl->id, an->index);
+    }
+    for (unsigned int i = first_di; i < tbl->n_di; i++) {
+        for (unsigned int j = first_di; j < i; j++) {
+            if (tbl->di[j].index == tbl->di[i].index)
+                return parse_fail(jp, "duplicate digital input 0x%04X on slave %d",
+                                  tbl->di[i].index, sl->id);
+        }
+        tbl->di[i].slave_id = sl->id;
+        tbl->di[i].master = sl->master;
+    }
+    tbl->n_slaves++;
+    return 0;
+}
+
+static int on_root_key(json_parser_t *jp, const char *key, void *ctx)
+{
+    if (!strcmp(key, "network"))
+        return parse_object(jp, on_network_key, ctx);
+    if (!strcmp(key, "slaves"))
+        return parse_array(jp, on_slave_item, ctx);
+    return 1;
+}
+
+static int cmp_master(const void *a, const void *b)
+{
+    const master_config_t *x = a, *y = b;
+    return (x->index > y->index) - (x->index < y->index);
+}
+
+static int cmp_analog(const void *a, const void *b)
+{
+    const analog_config_t *x = a, *y = b;
+    if (x->master != y->master)
+        return (x->master > y->master) - (x->master < y->master);
+    if (x->slave_id != y->slave_id)
+        return (x->slave_id > y->slave_id) - (x->slave_id < y->slave_id);
+    return (x->index > y->index) - (x->index < y->index);
+}
+
+static int cmp_di(const void *a, const void *b)
+{
+    const di_config_t *x = a, *y = b;
+    if (x->master != y->master)
+        return (x->master > y->master) - (x->master < y->master);
+    if (x->slave_id != y->slave_id)
+        return (x->slave_id > y->slave_id) - (x->slave_id < y->slave_id);
+    return (x->index > y->index) - (x->index < y->index);
+}
+
+static int cmp_slave(const void *a, const void *b)
+{
+    const slave_config_t *x = a, *y = b;
+    if (x->master != y->master)
+        return (x->master > y->master) - (x->master < y->master);
+    return (x->id > y->id) - (x->id < y->id);
+}
+
+static int cmp_axis(const void *a, const void *b)
+{
+    const axis_config_t *x = a, *y = b;
+    if (x->master != y->master)
+        return (x->master > y->master) - (x->master < y->master);
+    if (x->slave_id != y->slave_id)
+        return (x->slave_id > y->slave_id) - (x->slave_id < y->slave_id);
+    return (x->offset > y->offset) - (x->offset < y->offset);
+}
+
+int axis_config_parse(const char *text, size_t len, axis_config_table_t *out,
+                      char *err, size_t err_len)
+{
+    if (!text || !out)
+        return -EINVAL;
+
+    json_parser_t jp = {text, text + len, 1, err, err_len};
+    if (err && err_len)
+        err[0] = '\0';
+
+    memset(out, 0, sizeof(*out));
+    strncpy(out->eni_path, AXIS_DEFAULT_ENI_PATH, sizeof(out->eni_path) - 1);
+    out->cycle_us = AXIS_DEFAULT_CYCLE_US;
+    out->n_masters = 1;
+    out->masters[0].index = 0;
+    out->masters[0].cpu = -1;
+
+    parse_ctx_t pc = {.tbl = out};
+    int r = parse_object(&jp, on_root_key, &pc);
+    if (!r && peek(&jp) != -1)
+        r = parse_fail(&jp, "trailing data after root object");
+    if (!r && !out->n_slaves)
+        r = parse_fail(&jp, "'slaves' is missing or empty");
+    if (!r && !out->n_masters)
+        r = parse_fail(&jp, "'masters' is empty");
+    /* masters 可以写在 slaves 之后，引用关系在整体解析完成后检查 */
+    for (unsigned int i = 0; !r && i < out->n_slaves; i++) {
+        unsigned int m = 0;
+        while (m < out->n_masters && out->masters[m].index != out->slaves[i].master)
+            m++;
+        if (m == out->n_masters) {
+            if (err && err_len)
+                snprintf(err, err_len, "slave %d references undeclared master %d",
+                         out->slaves[i].id, out->slaves[i].master);
+            r = -EINVAL;
+        }
+    }
+    for (unsigned int i = 0; !r && i < out->n_analog; i++) {
+        for (unsigned int j = 0; j < i; j++) {
+            if (!strcmp(out->analog[i].name, out->analog[j].name)) {
+                if (err && err_len)
+                    snprintf(err, err_len, "duplicate analog channel name '%s'",
+                             out->analog[i].name);
+                r = -EINVAL;
+                break;
+            }
+        }
+    }
+    if (r) {
+        if (r == -ENOMEM && err && err_len)
+            snprintf(err, err_len, "out of memory");
+        axis_config_free(out);
+        return r;
+    }
+
+    /* 同一主站、同一从站的轴排在一起，稠密下标与主站/从站分组一致 */
+    qsort(out->masters, out->n_masters, sizeof(*out->masters), cmp_master);
+    qsort(out->slaves, out->n_slaves, sizeof(*out->slaves), cmp_slave);
+    qsort(out->axes, out->n_axes, sizeof(*out->axes), cmp_axis);
+    if (out->n_analog)
+        qsort(out->analog, out->n_analog, sizeof(*out->analog), cmp_analog);
+    if (out->n_di)
+        qsort(out->di, out->n_di, sizeof(*out->di), cmp_di);
+    return 0;
+}
+
+int axis_config_load(const char *path, axis_config_table_t *out, char *err, size_t err_len)
+{
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        int e = errno;
+        if (err && err_len)
+            snprintf(err, err_len, "%s: %s", path, strerror(e));
+        return -e;
+    }
+
+    size_t cap = 16384, len = 0;
+    char *buf = malloc(cap);
+    while (buf) {
+        len += fread(buf + len, 1, cap - len, fp);
+        if (len < cap)
+            break;
+        char *nb = realloc(buf, cap * 2);
+        if (!nb) {
+            free(buf);
+            buf = NULL;
+            break;
+        }
+        buf = nb;
+        cap *= 2;
+    }
+    int read_err = ferror(fp);
+    fclose(fp);
+    if (!buf)
+        return -ENOMEM;
+    if (read_err) {
+        free(buf);
+        if (err && err_len)
+            snprintf(err, err_len, "%s: read error", path);
+        return -EIO;
+    }
+
+    int r = axis_config_parse(buf, len, out, err, err_len);
+    free(buf);
+    return r;
+}
+
+const axis_config_t *axis_config_find(const axis_config_table_t *tbl, int axis_id)
+{
+    for (unsigned int i = 0; i < tbl->n_axes; i++) {
+        if (tbl->axes[i].axis_id == axis_id)
+            return &tbl->axes[i];
+    }
+    return NULL;
+}
+
+int axis_config_copy(axis_config_table_t *dst, const axis_config_table_t *src)
+{
+    slave_config_t *slaves = dst->slaves;
+    axis_config_t *axes = dst->axes;
+    analog_config_t *analog = dst->analog;
+    di_config_t *di = dst->di;
+    if (dst->n_slaves < src->n_slaves) {
+        slaves = realloc(slaves, (src->n_slaves ? src->n_slaves : 1) * sizeof(*slaves));
+        if (!slaves)
+            return -ENOMEM;
+        dst->slaves = slaves;
+    }
+    if (dst->n_axes < src->n_axes) {
+        axes = realloc(axes, (src->n_axes ? src->n_axes : 1) * sizeof(*axes));
+        if (!axes)
+            return -ENOMEM;
+        dst->axes = axes;
+    }
+    if (dst->n_analog < src->n_analog) {
+        analog = realloc(analog, src->n_analog * sizeof(*analog));
+        if (!analog)
+            return -ENOMEM;
+        dst->analog = analog;
+    }
+    if (dst->n_di < src->n_di) {
+        di = realloc(di, src->n_di * sizeof(*di));
+        if (!di)
+            return -ENOMEM;
+        dst->di = di;
+    }
+    memcpy(dst->eni_path, src->eni_path, sizeof(dst->eni_path));
+    dst->cycle_us = src->cycle_us;
+    dst->overrun_policy = src->overrun_policy;
+    dst->max_catchup = src->max_catchup;
+    dst->safe_after_misses = src->safe_after_misses;
+    dst->n_masters = src->n_masters;
+    memcpy(dst->masters, src->masters, sizeof(dst->masters));
+    dst->n_slaves = src->n_slaves;
+    dst->n_axes = src->n_axes;
+    dst->n_analog = src->n_analog;
+    dst->n_di = src->n_di;
+    if (src->n_slaves)
+        memcpy(slaves, src->slaves, src->n_slaves * sizeof(*slaves));
+    if (src->n_axes)
+        memcpy(axes, src->axes, src->n_axes * sizeof(*axes));
+    if (src->n_analog)
+        memcpy(analog, src->analog, src->n_analog * sizeof(*analog));
+    if (src->n_di)
+        memcpy(di, src->di, src->n_di * sizeof(*di));
+    return 0;
+}
+
+int axis_config_equal(const axis_config_table_t *a, const axis_config_table_t *b)
+{
+    if (strcmp(a->eni_path, b->eni_path) || a->cycle_us != b->cycle_us ||
+        a->overrun_policy != b->overrun_policy || a->max_catchup != b->max_catchup ||
+        a->safe_after_misses != b->safe_after_misses ||
+        a->n_slaves != b->n_slaves || a->n_axes != b->n_axes || a->n_masters != b->n_masters ||
+        a->n_analog != b->n_analog || a->n_di != b->n_di)
+        return 0;
+    for (unsigned int i = 0; i < a->n_masters; i++) {
+        if (a->masters[i].index != b->masters[i].index || a->masters[i].cpu != b->masters[i].cpu)
+            return 0;
+    }
+    for (unsigned int i = 0; i < a->n_slaves; i++) {
+        if (a->slaves[i].id != b->slaves[i].id || a->slaves[i].master != b->slaves[i].master ||
+            a->slaves[i].type != b->slaves[i].type ||
+            a->slaves[i].modbus_gateway != b->slaves[i].modbus_gateway)
+            return 0;
+    }
+    for (unsigned int i = 0; i < a->n_axes; i++) {
+        const axis_config_t *x = &a->axes[i], *y = &b->axes[i];
+        if (x->axis_id != y->axis_id || x->slave_id != y->slave_id || x->master != y->master ||
+            x->type != y->type ||
+            x->offset != y->offset || x->encoder_res != y->encoder_res ||
+            x->gear_ratio != y->gear_ratio || x->unit_per_rev != y->unit_per_rev)
+            return 0;
+    }
+    for (unsigned int i = 0; i < a->n_analog; i++) {
+        const analog_config_t *x = &a->analog[i], *y = &b->analog[i];
+        if (strcmp(x->name, y->name) || x->slave_id != y->slave_id || x->master != y->master ||
+            x->index != y->index || x->is_signed != y->is_signed || x->median != y->median ||
+            x->avg_window != y->avg_window || x->has_high != y->has_high ||
+            x->has_low != y->has_low || x->gain != y->gain || x->offset != y->offset ||
+            x->iir_alpha != y->iir_alpha || x->high != y->high || x->low != y->low ||
+            x->hysteresis != y->hysteresis)
+            return 0;
+    }
+    for (unsigned int i = 0; i < a->n_di; i++) {
+        const di_config_t *x = &a->di[i], *y = &b->di[i];
+        if (x->slave_id != y->slave_id || x->master != y->master || x->index != y->index)
+            return 0;
+    }
+    return 1;
+}
+
+void axis_config_free(axis_config_table_t *tbl)
+{
+    if (!tbl)
+        return;
+    free(tbl->slaves);
+    free(tbl->axes);
+    free(tbl->analog);
+    free(tbl->di);
+    tbl->slaves = NULL;
+    tbl->axes = NULL;
+    tbl->analog = NULL;
+    tbl->di = NULL;
+    tbl->n_slaves = 0;
+    tbl->n_axes = 0;
+    tbl->n_analog = 0;
+    tbl->n_di = 0;
+}
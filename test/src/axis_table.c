@@ -0,0 +1,470 @@
+/*
+ * axis_table.c
+ *
+ * 轴表的校验、domain 注册表生成与指针绑定，接口说明见 axis_table.h。
+ */
+
+#include "axis_table.h"
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* axis_table_t 中的 PDO 指针字段 */
+typedef enum {
+    FIELD_CONTROL_WORD = 0,
+    FIELD_TARGET_POS,
+    FIELD_MODE_OF_OP,
+    FIELD_STATUS_WORD,
+    FIELD_ACTUAL_POS,
+    FIELD_MODE_DISPLAY,
+    FIELD_ERROR_CODE,
+    FIELD_PROBE_FUNC,
+    FIELD_PROBE_STATUS,
+    FIELD_PROBE_POS,
+    FIELD_IO_OUT,
+    FIELD_IO_IN,
+    FIELD_COUNT,
+} axis_field_t;
+
+typedef struct {
+    uint16_t       index;     /* 基地址，实际索引为 index + offset */
+    ec_direction_t dir;
+    int            required;
+    uint8_t        bits;      /* 周期任务按此宽度读写 */
+    axis_field_t   field;
+} field_spec_t;
+
+static const field_spec_t cia402_fields[] = {
+    {0x6040, EC_DIR_OUTPUT, 1, 16, FIELD_CONTROL_WORD},
+    {0x607a, EC_DIR_OUTPUT, 1, 32, FIELD_TARGET_POS},
+    {0x6060, EC_DIR_OUTPUT, 0, 8, FIELD_MODE_OF_OP},
+    {0x6041, EC_DIR_INPUT, 1, 16, FIELD_STATUS_WORD},
+    {0x6064, EC_DIR_INPUT, 1, 32, FIELD_ACTUAL_POS},
+    {0x6061, EC_DIR_INPUT, 0, 8, FIELD_MODE_DISPLAY},
+    {0x603f, EC_DIR_INPUT, 0, 16, FIELD_ERROR_CODE},
+    {0x60b8, EC_DIR_OUTPUT, 0, 16, FIELD_PROBE_FUNC},
+    {0x60b9, EC_DIR_INPUT, 0, 16, FIELD_PROBE_STATUS},
+    {0x60ba, EC_DIR_INPUT, 0, 32, FIELD_PROBE_POS},
+};
+
+#define FIELDS_PER_AXIS (sizeof(cia402_fields) / sizeof(cia402_fields[0]))
+
+/* 每个注册项对应的轴与字段，bind 时使用 */
+typedef struct {
+    uint32_t axis;
+    uint8_t  field;
+} reg_target_t;
+
+typedef struct {
+    axis_table_t  pub;
+    reg_target_t *targets;
+} axis_table_impl_t;
+
+#define OPERATION_ENABLED_MASK  0x006F
+#define OPERATION_ENABLED_STATE 0x0027
+
+static int table_fail(char *err, size_t err_len, const char *fmt, ...)
+{
+    if (err && err_len) {
+        va_list ap;
+        va_start(ap, fmt);
+        vsnprintf(err, err_len, fmt, ap);
+        va_end(ap);
+    }
+    return -EINVAL;
+}
+
+/* 在 PDO 映射中查找对象；找到返回 0，并给出子索引、位宽与方向 */
+static int pdo_lookup(const ec_sync_info_t *syncs, uint16_t index, uint8_t *subindex,
+                      uint8_t *bits, ec_direction_t *dir)
+{
+    for (const ec_sync_info_t *sm = syncs; sm && sm->index != 0xff; sm++) {
+        for (unsigned int p = 0; p < sm->n_pdos; p++) {
+            const ec_pdo_info_t *pdo = &sm->pdos[p];
+            for (unsigned int e = 0; e < pdo->n_entries; e++) {
+                if (pdo->entries[e].index == index) {
+                    *subindex = pdo->entries[e].subindex;
+                    *bits = pdo->entries[e].bit_length;
+                    *dir = sm->dir;
+                    return 0;
+                }
+            }
+        }
+    }
+    return -1;
+}
+
+static const axis_slave_desc_t *find_slave(const axis_slave_desc_t *slaves, unsigned int n,
+                                           int position)
+{
+    for (unsigned int i = 0; i < n; i++) {
+        if (slaves[i].position == position)
+            return &slaves[i];
+    }
+    return NULL;
+}
+
+static void add_reg(axis_table_impl_t *impl, const axis_slave_desc_t *sd, uint16_t index,
+                    uint8_t subindex, unsigned int axis, axis_field_t field)
+{
+    axis_table_t *at = &impl->pub;
+    ec_pdo_entry_reg_t *r = &at->regs[at->n_regs];
+    r->alias = sd->alias;
+    r->position = sd->position;
+    r->vendor_id = sd->vendor_id;
+    r->product_code = sd->product_code;
+    r->index = index;
+    r->subindex = subindex;
+    r->offset = &at->offsets[at->n_regs];
+    r->bit_position = NULL;
+    impl->targets[at->n_regs].axis = axis;
+    impl->targets[at->n_regs].field = (uint8_t)field;
+    at->n_regs++;
+}
+
+static int setup_cia402(axis_table_impl_t *impl, const axis_config_t *ax,
+                        const axis_slave_desc_t *sd, unsigned int i, char *err, size_t err_len)
+{
+    unsigned int probe_fields = 0;
+    for (size_t f = 0; f < FIELDS_PER_AXIS; f++) {
+        const field_spec_t *fs = &cia402_fields[f];
+        uint16_t index = (uint16_t)(fs->index + ax->offset);
+        uint8_t sub, bits;
+        ec_direction_t dir;
+        if (pdo_lookup(sd->syncs, index, &sub, &bits, &dir)) {
+            if (!fs->required)
+                continue;
+            return table_fail(err, err_len,
+                              "axis %d: 0x%04X (offset 0x%X) not in PDO map of slave %d",
+                              ax->axis_id, index, ax->offset, ax->slave_id);
+        }
+        if (dir != fs->dir)
+            return table_fail(err, err_len, "axis %d: 0x%04X mapped in wrong direction",
+                              ax->axis_id, index);
+        if (bits != fs->bits)
+            return table_fail(err, err_len, "axis %d: 0x%04X is %u bits, expected %u",
+                              ax->axis_id, index, bits, fs->bits);
+        add_reg(impl, sd, index, sub, i, fs->field);
+        if (fs->field >= FIELD_PROBE_FUNC && fs->field <= FIELD_PROBE_POS)
+            probe_fields++;
+    }
+    /* 探针三个对象齐全才可用 */
+    if (probe_fields == 3)
+        axis_mask_set(impl->pub.probe_mask, i);
+    return 0;
+}
+
+static int setup_io(axis_table_impl_t *impl, const axis_config_t *ax,
+                    const axis_slave_desc_t *sd, unsigned int i, char *err, size_t err_len)
+{
+    axis_table_t *at = &impl->pub;
+    uint8_t sub, bits;
+    ec_direction_t dir;
+
+    /* 输入：0x6000+offset (INEXBOT) 或 0x6001+offset (F2838x) */
+    uint16_t in_idx = (uint16_t)(0x6000 + ax->offset);
+    if (pdo_lookup(sd->syncs, in_idx, &sub, &bits, &dir) || dir != EC_DIR_INPUT) {
+        in_idx++;
+        if (pdo_lookup(sd->syncs, in_idx, &sub, &bits, &dir) || dir != EC_DIR_INPUT)
+            return table_fail(err, err_len,
+                              "axis %d: no digital input at 0x%04X/0x%04X on io slave %d",
+                              ax->axis_id, in_idx - 1, in_idx, ax->slave_id);
+    }
+    at->io_in_bits[i] = bits;
+    add_reg(impl, sd, in_idx, sub, i, FIELD_IO_IN);
+
+    /* 输出可选：0x7000+offset 或 0x7001+offset */
+    uint16_t out_idx = (uint16_t)(0x7000 + ax->offset);
+    if (!pdo_lookup(sd->syncs, out_idx, &sub, &bits, &dir) && dir == EC_DIR_OUTPUT) {
+        at->io_out_bits[i] = bits;
+        add_reg(impl, sd, out_idx, sub, i, FIELD_IO_OUT);
+    } else if (!pdo_lookup(sd->syncs, ++out_idx, &sub, &bits, &dir) && dir == EC_DIR_OUTPUT) {
+        at->io_out_bits[i] = bits;
+        add_reg(impl, sd, out_idx, sub, i, FIELD_IO_OUT);
+    }
+    return 0;
+}
+
+/* 64 字节对齐并清零的数组，长度向上取整到整 cache line */
+static void *alloc_array(size_t n, size_t elem)
+{
+    size_t bytes = (n ? n : 1) * elem;
+    bytes = (bytes + 63) & ~(size_t)63;
+    void *p = aligned_alloc(64, bytes);
+    if (p)
+        memset(p, 0, bytes);
+    return p;
+}
+
+static int alloc_fields(axis_table_t *at, unsigned int n, unsigned int n_slaves)
+{
+    at->slaves = alloc_array(n_slaves, sizeof(*at->slaves));
+    at->control_word = alloc_array(n, sizeof(*at->control_word));
+    at->target_pos = alloc_array(n, sizeof(*at->target_pos));
+    at->mode_of_op = alloc_array(n, sizeof(*at->mode_of_op));
+    at->status_word = alloc_array(n, sizeof(*at->status_word));
+    at->actual_pos = alloc_array(n, sizeof(*at->actual_pos));
+    at->mode_display = alloc_array(n, sizeof(*at->mode_display));
+    at->error_code = alloc_array(n, sizeof(*at->error_code));
+    at->probe_func = alloc_array(n, sizeof(*at->probe_func));
+    at->probe_status = alloc_array(n, sizeof(*at->probe_status));
+    at->probe_pos = alloc_array(n, sizeof(*at->probe_pos));
+    at->io_out = alloc_array(n, sizeof(*at->io_out));
+    at->io_in = alloc_array(n, sizeof(*at->io_in));
+    at->scale = alloc_array(n, sizeof(*at->scale));
+    at->inv_scale = alloc_array(n, sizeof(*at->inv_scale));
+    at->axis_id = alloc_array(n, sizeof(*at->axis_id));
+    at->slave_pos = alloc_array(n, sizeof(*at->slave_pos));
+    at->type = alloc_array(n, sizeof(*at->type));
+    at->io_out_bits = alloc_array(n, sizeof(*at->io_out_bits));
+    at->io_in_bits = alloc_array(n, sizeof(*at->io_in_bits));
+    at->cia402_mask = alloc_array(AXIS_MASK_WORDS(n), sizeof(uint64_t));
+    at->probe_mask = alloc_array(AXIS_MASK_WORDS(n), sizeof(uint64_t));
+    return at->slaves && at->control_word && at->target_pos && at->mode_of_op &&
+                   at->status_word && at->actual_pos && at->mode_display && at->error_code &&
+                   at->probe_func && at->probe_status && at->probe_pos &&
+                   at->io_out && at->io_in && at->scale && at->inv_scale && at->axis_id &&
+                   at->slave_pos && at->type && at->io_out_bits && at->io_in_bits &&
+                   at->cia402_mask && at->probe_mask
+               ? 0
+               : -ENOMEM;
+}
+
+int axis_table_create(const axis_config_table_t *cfg, const axis_slave_desc_t *slaves,
+                      unsigned int n_slaves, axis_table_t **out, char *err, size_t err_len)
+{
+    if (!cfg || !out || (n_slaves && !slaves))
+        return -EINVAL;
+
+    /* 一张轴表只对应一条总线，多主站配置由 master_group 按主站拆分 */
+    for (unsigned int s = 1; s < cfg->n_slaves; s++) {
+        if (cfg->slaves[s].master != cfg->slaves[0].master)
+            return table_fail(err, err_len, "config spans masters %d and %d (use master_group)",
+                              cfg->slaves[0].master, cfg->slaves[s].master);
+    }
+
+    /* 从站存在性与类型一致性 */
+    for (unsigned int s = 0; s < cfg->n_slaves; s++) {
+        const slave_config_t *sc = &cfg->slaves[s];
+        const axis_slave_desc_t *sd = find_slave(slaves, n_slaves, sc->id);
+        if (!sd)
+            return table_fail(err, err_len, "slave %d not present in bus layout", sc->id);
+        uint8_t sub, bits;
+        ec_direction_t dir;
+        int is_drive = !pdo_lookup(sd->syncs, 0x6040, &sub, &bits, &dir);
+        if (sc->type == SLAVE_TYPE_IO && is_drive)
+            return table_fail(err, err_len,
+                              "slave %d configured as io but its PDO map is CiA402", sc->id);
+        if (sc->type == SLAVE_TYPE_CIA402 && !is_drive)
+            return table_fail(err, err_len,
+                              "slave %d configured as cia402 but maps no 0x6040", sc->id);
+    }
+
+    axis_table_impl_t *impl = calloc(1, sizeof(*impl));
+    if (!impl)
+        return -ENOMEM;
+    axis_table_t *at = &impl->pub;
+    unsigned int n = cfg->n_axes;
+    int max_id = -1;
+    for (unsigned int i = 0; i < n; i++) {
+        if (cfg->axes[i].axis_id > max_id)
+            max_id = cfg->axes[i].axis_id;
+    }
+    size_t max_regs = (size_t)n * FIELDS_PER_AXIS;
+    at->index_of_len = (unsigned int)(max_id + 1);
+    at->index_of = malloc((at->index_of_len ? at->index_of_len : 1) * sizeof(*at->index_of));
+    at->regs = calloc(max_regs + 1, sizeof(*at->regs));
+    at->offsets = calloc(max_regs + 1, sizeof(*at->offsets));
+    impl->targets = calloc(max_regs + 1, sizeof(*impl->targets));
+    if (alloc_fields(at, n, cfg->n_slaves) || !at->index_of || !at->regs || !at->offsets ||
+        !impl->targets) {
+        axis_table_destroy(at);
+        return -ENOMEM;
+    }
+    for (unsigned int i = 0; i < at->index_of_len; i++)
+        at->index_of[i] = -1;
+
+    /* 配置中的轴已按 (从站, offset) 排序，直接按从站切分区间 */
+    int r = 0;
+    for (unsigned int i = 0; i < n && !r; i++) {
+        const axis_config_t *ax = &cfg->axes[i];
+        const axis_slave_desc_t *sd = find_slave(slaves, n_slaves, ax->slave_id);
+
+        if (i && cfg->axes[i - 1].slave_id == ax->slave_id &&
+            cfg->axes[i - 1].offset == ax->offset) {
+            r = table_fail(err, err_len, "axis %d and axis %d share slave %d offset 0x%X",
+                           cfg->axes[i - 1].axis_id, ax->axis_id, ax->slave_id, ax->offset);
+            break;
+        }
+        if (!at->n_slaves || at->slaves[at->n_slaves - 1].position != sd->position) {
+            axis_slave_span_t *span = &at->slaves[at->n_slaves++];
+            span->position = sd->position;
+            span->type = (uint8_t)ax->type;
+            span->first = i;
+        }
+        at->slaves[at->n_slaves - 1].count++;
+
+        at->axis_id[i] = ax->axis_id;
+        at->slave_pos[i] = sd->position;
+        at->type[i] = (uint8_t)ax->type;
+        at->scale[i] = ax->scale;
+        at->inv_scale[i] = 1.0 / ax->scale;
+        at->index_of[ax->axis_id] = (int32_t)i;
+
+        if (ax->type == SLAVE_TYPE_IO) {
+            r = setup_io(impl, ax, sd, i, err, err_len);
+        } else {
+            axis_mask_set(at->cia402_mask, i);
+            r = setup_cia402(impl, ax, sd, i, err, err_len);
+        }
+    }
+    if (r) {
+        axis_table_destroy(at);
+        return r;
+    }
+
+    at->n_axes = n;
+    *out = at;
+    return 0;
+}
+
+const ec_pdo_entry_reg_t *axis_table_regs(const axis_table_t *at)
+{
+    return at->regs;
+}
+
+int axis_table_bind(axis_table_t *at, uint8_t *domain_pd)
+{
+    if (!at || !domain_pd)
+        return -EINVAL;
+
+    axis_table_impl_t *impl = (axis_table_impl_t *)at;
+    for (unsigned int r = 0; r < at->n_regs; r++) {
+        unsigned int i = impl->targets[r].axis;
+        uint8_t *p = domain_pd + at->offsets[r];
+        switch ((axis_field_t)impl->targets[r].field) {
+        case FIELD_CONTROL_WORD: at->control_word[i] = p; break;
+        case FIELD_TARGET_POS:   at->target_pos[i] = p; break;
+        case FIELD_MODE_OF_OP:   at->mode_of_op[i] = p; break;
+        case FIELD_STATUS_WORD:  at->status_word[i] = p; break;
+        case FIELD_ACTUAL_POS:   at->actual_pos[i] = p; break;
+        case FIELD_MODE_DISPLAY: at->mode_display[i] = p; break;
+        case FIELD_ERROR_CODE:   at->error_code[i] = p; break;
+        case FIELD_PROBE_FUNC:   at->probe_func[i] = p; break;
+        case FIELD_PROBE_STATUS: at->probe_status[i] = p; break;
+        case FIELD_PROBE_POS:    at->probe_pos[i] = p; break;
+        case FIELD_IO_OUT:       at->io_out[i] = p; break;
+        case FIELD_IO_IN:        at->io_in[i] = p; break;
+        default: break;
+        }
+    }
+    at->bound = 1;
+    return 0;
+}
+
+void axis_table_apply_scales(axis_table_t *at, const axis_config_table_t *cfg)
+{
+    for (unsigned int i = 0; i < cfg->n_axes; i++) {
+        int idx = axis_table_index(at, cfg->axes[i].axis_id);
+        if (idx < 0)
+            continue;
+        at->scale[idx] = cfg->axes[i].scale;
+        at->inv_scale[idx] = 1.0 / cfg->axes[i].scale;
+    }
+}
+
+static inline int32_t to_pulses(double user, double scale)
+{
+    double p = user * scale;
+    return (int32_t)(p >= 0.0 ? p + 0.5 : p - 0.5);
+}
+
+void axis_table_write_targets(axis_table_t *at, const uint64_t *mask, const double *pos)
+{
+    for (unsigned int w = 0; w < AXIS_MASK_WORDS(at->n_axes); w++) {
+        for (uint64_t bits = mask[w] & at->cia402_mask[w]; bits; bits &= bits - 1) {
+            unsigned int i = w * 64u + (unsigned int)__builtin_ctzll(bits);
+            EC_WRITE_S32(at->target_pos[i], to_pulses(pos[i], at->scale[i]));
+        }
+    }
+}
+
+void axis_table_write_targets_span(axis_table_t *at, unsigned int first, unsigned int count,
+                                   const double *pos)
+{
+    for (unsigned int i = first; i < first + count; i++) {
+        if (at->target_pos[i])
+            EC_WRITE_S32(at->target_pos[i], to_pulses(pos[i], at->scale[i]));
+    }
+}
+
+void axis_table_read_positions(const axis_table_t *at, const uint64_t *mask, double *pos)
+{
+    for (unsigned int w = 0; w < AXIS_MASK_WORDS(at->n_axes); w++) {
+        for (uint64_t bits = mask[w] & at->cia402_mask[w]; bits; bits &= bits - 1) {
+            unsigned int i = w * 64u + (unsigned int)__builtin_ctzll(bits);
+            pos[i] = (double)EC_READ_S32(at->actual_pos[i]) * at->inv_scale[i];
+        }
+    }
+}
+
+void axis_table_write_control(axis_table_t *at, const uint64_t *mask, uint16_t control_word)
+{
+    for (unsigned int w = 0; w < AXIS_MASK_WORDS(at->n_axes); w++) {
+        for (uint64_t bits = mask[w] & at->cia402_mask[w]; bits; bits &= bits - 1) {
+            unsigned int i = w * 64u + (unsigned int)__builtin_ctzll(bits);
+            EC_WRITE_U16(at->control_word[i], control_word);
+        }
+    }
+}
+
+void axis_table_enabled_mask(const axis_table_t *at, uint64_t *out)
+{
+    for (unsigned int w = 0; w < AXIS_MASK_WORDS(at->n_axes); w++) {
+        uint64_t en = 0;
+        for (uint64_t bits = at->cia402_mask[w]; bits; bits &= bits - 1) {
+            unsigned int b = (unsigned int)__builtin_ctzll(bits);
+            uint16_t sw = EC_READ_U16(at->status_word[w * 64u + b]);
+            if ((sw & OPERATION_ENABLED_MASK) == OPERATION_ENABLED_STATE)
+                en |= 1ull << b;
+        }
+        out[w] = en;
+    }
+}
+
+void axis_table_destroy(axis_table_t *at)
+{
+    if (!at)
+        return;
+    axis_table_impl_t *impl = (axis_table_impl_t *)at;
+    free(at->slaves);
+    free(at->control_word);
+    free(at->target_pos);
+    free(at->mode_of_op);
+    free((void *)at->status_word);
+    free((void *)at->actual_pos);
+    free((void *)at->mode_display);
+    free((void *)at->error_code);
+    free(at->probe_func);
+    free((void *)at->probe_status);
+    free((void *)at->probe_pos);
+    free(at->io_out);
+    free((void *)at->io_in);
+    free(at->scale);
+    free(at->inv_scale);
+    free(at->axis_id);
+    free(at->slave_pos);
+    free(at->type);
+    free(at->io_out_bits);
+    free(at->io_in_bits);
+    free(at->cia402_mask);
+    free(at->probe_mask);
+    free(at->index_of);
+    free(at->regs);
+    free(at->offsets);
+    free(impl->targets);
+    free(impl);
+}
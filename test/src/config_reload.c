@@ -0,0 +1,417 @@
+/*
+ * config_reload.c
+ *
+ * 配置热加载实现，接口说明见 config_reload.h。
+ *
+ * 同步约定：
+ *   state = (generation << 2) | (pending << 1) | active (generation 为最近发布的版本)，一个原子字同时给出当前生效的 slot
+ *   和是否有待切换的配置 (待切换的总是另一个 slot)。generation 单调递增，避免 ABA。
+ *   - 只有监视线程置位 pending；RT 线程只在 pending 置位时翻转 active，两者在同一次 CAS 中完成。
+ *   - 监视线程先用 CAS 清除 pending，此后 active 不会再变，另一个 slot 归监视线程所有。
+ *   - RT 线程 CAS 成功即说明读到的 moved_mask 就是发布时的内容，且旧 active slot
+ *     从此刻起归监视线程所有。
+ */
+
+#define _GNU_SOURCE
+
+#include "config_reload.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+typedef struct {
+    axis_config_table_t tbl;
+    _Atomic uint64_t   *moved_mask;  /* 会使驱动器运动的轴 (按稠密下标)，mask_words 个字 */
+} config_slot_t;
+
+struct config_reload {
+    char                   path[PATH_MAX];
+    char                   dir[PATH_MAX];
+    char                   base[NAME_MAX + 1];
+    config_reload_policy_t policy;
+    int                    inotify_fd;
+    int                    stop_fd;
+    pthread_t              thread;
+
+    config_slot_t    slots[2];
+    unsigned int     mask_words;
+    _Atomic uint64_t state;
+    uint32_t         next_generation;
+    _Atomic uint32_t generation;      /* 已生效的版本 */
+    int             *axis_ids;        /* 按稠密下标，热加载不会改变 */
+
+    _Atomic uint32_t applied;
+    _Atomic uint32_t rejected;
+    _Atomic uint32_t held_cycles;
+
+    /*
+     * 按策略拒绝发生在 RT 线程，不能加锁写 last_error：只记下被拒的版本与轴，
+     * 由 config_reload_get_status() 按事件顺序生成说明。
+     */
+    _Atomic uint32_t event_seq;
+    _Atomic uint32_t policy_reject_seq;
+    _Atomic uint64_t policy_reject;   /* (generation << 32) | axis_id */
+    uint32_t         error_seq;       /* last_error 对应的事件序号，受 err_lock 保护 */
+
+    pthread_mutex_t  err_lock;
+    char             last_error[160];
+};
+
+#define STATE_PENDING 2u
+#define STATE_ACTIVE(s) ((unsigned int)((s) & 1u))
+
+static void set_error(config_reload_t *cr, const char *fmt, ...)
+{
+    pthread_mutex_lock(&cr->err_lock);
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(cr->last_error, sizeof(cr->last_error), fmt, ap);
+    va_end(ap);
+    cr->error_seq = atomic_fetch_add_explicit(&cr->event_seq, 1, memory_order_relaxed) + 1;
+    pthread_mutex_unlock(&cr->err_lock);
+    atomic_fetch_add_explicit(&cr->rejected, 1, memory_order_relaxed);
+}
+
+/*
+ * 比较新旧配置。拓扑不一致返回 -1 并写入原因；
+ * 否则返回 0，并在 moved 中给出会使驱动器运动的轴。
+ */
+static int diff_tables(const axis_config_table_t *old, const axis_config_table_t *new_tbl,
+                       uint64_t *moved, char *why, size_t why_len)
+{
+    if (strcmp(old->eni_path, new_tbl->eni_path)) {
+        snprintf(why, why_len, "eni_path changed (bus restart required)");
+        return -1;
+    }
+    if (old->n_slaves != new_tbl->n_slaves || old->n_axes != new_tbl->n_axes) {
+        snprintf(why, why_len, "slave/axis count changed (bus restart required)");
+        return -1;
+    }
+    /* 周期已用于调度器、超时换算与驱动器插补，运行中无法重新编排 */
+    if (old->cycle_us != new_tbl->cycle_us) {
+        snprintf(why, why_len, "cycle_us changed from %u to %u (restart required)",
+                 old->cycle_us, new_tbl->cycle_us);
+        return -1;
+    }
+    if (old->overrun_policy != new_tbl->overrun_policy ||
+        old->max_catchup != new_tbl->max_catchup ||
+        old->safe_after_misses != new_tbl->safe_after_misses) {
+        snprintf(why, why_len, "overrun settings changed (restart required)");
+        return -1;
+    }
+    if (old->n_masters != new_tbl->n_masters ||
+        memcmp(old->masters, new_tbl->masters, old->n_masters * sizeof(old->masters[0]))) {
+        snprintf(why, why_len, "masters changed (bus restart required)");
+        return -1;
+    }
+    for (unsigned int i = 0; i < old->n_slaves; i++) {
+        if (old->slaves[i].id != new_tbl->slaves[i].id ||
+            old->slaves[i].master != new_tbl->slaves[i].master ||
+            old->slaves[i].type != new_tbl->slaves[i].type ||
+            old->slaves[i].modbus_gateway != new_tbl->slaves[i].modbus_gateway) {
+            snprintf(why, why_len, "slave %d changed (bus restart required)",
+                     new_tbl->slaves[i].id);
+            return -1;
+        }
+    }
+    /* 模拟量通道的 PDO 映射固定在 domain 中，只允许修改滤波参数 */
+    if (old->n_analog != new_tbl->n_analog) {
+        snprintf(why, why_len, "analog channel count changed (bus restart required)");
+        return -1;
+    }
+    for (unsigned int i = 0; i < old->n_analog; i++) {
+        const analog_config_t *oa = &old->analog[i], *na = &new_tbl->analog[i];
+        if (strcmp(oa->name, na->name) || oa->slave_id != na->slave_id ||
+            oa->master != na->master || oa->index != na->index ||
+            oa->is_signed != na->is_signed) {
+            snprintf(why, why_len, "analog '%s' mapping changed (bus restart required)",
+                     na->name);
+            return -1;
+        }
+    }
+    int di_changed = old->n_di != new_tbl->n_di;
+    for (unsigned int i = 0; !di_changed && i < old->n_di; i++) {
+        di_changed = old->di[i].slave_id != new_tbl->di[i].slave_id ||
+                     old->di[i].master != new_tbl->di[i].master ||
+                     old->di[i].index != new_tbl->di[i].index;
+    }
+    if (di_changed) {
+        snprintf(why, why_len, "digital inputs changed (bus restart required)");
+        return -1;
+    }
+
+    /* 两份表都按 (从站, offset) 排序，映射不变时下标一一对应 */
+    axis_mask_clear_all(moved, new_tbl->n_axes);
+    for (unsigned int i = 0; i < new_tbl->n_axes; i++) {
+        const axis_config_t *na = &new_tbl->axes[i];
+        const axis_config_t *oa = &old->axes[i];
+        if (oa->axis_id != na->axis_id || oa->slave_id != na->slave_id ||
+            oa->master != na->master || oa->offset != na->offset) {
+            snprintf(why, why_len, "axis %d mapping changed (bus restart required)",
+                     na->axis_id);
+            return -1;
+        }
+        if (oa->scale != na->scale)
+            axis_mask_set(moved, i);
+    }
+    return 0;
+}
+
+static void reload(config_reload_t *cr)
+{
+    axis_config_table_t tbl;
+    char err[160];
+    int r = axis_config_load(cr->path, &tbl, err, sizeof(err));
+    if (r) {
+        set_error(cr, "%s", err);
+        return;
+    }
+    if (AXIS_MASK_WORDS(tbl.n_axes) > cr->mask_words) {
+        set_error(cr, "slave/axis count changed (bus restart required)");
+        axis_config_free(&tbl);
+        return;
+    }
+
+    /* 撤回尚未生效的旧版本，拿到空闲 slot 的所有权；清除后 active 不再变化 */
+    uint64_t w = atomic_load_explicit(&cr->state, memory_order_acquire);
+    while ((w & STATE_PENDING) &&
+           !atomic_compare_exchange_weak_explicit(&cr->state, &w, w & ~(uint64_t)STATE_PENDING,
+                                                  memory_order_acq_rel, memory_order_acquire))
+        ;
+    unsigned int active = STATE_ACTIVE(w);
+    config_slot_t *cur = &cr->slots[active];
+    config_slot_t *next = &cr->slots[active ^ 1];
+
+    uint64_t moved[cr->mask_words];
+    char why[128];
+    if (diff_tables(&cur->tbl, &tbl, moved, why, sizeof(why))) {
+        set_error(cr, "%s", why);
+        axis_config_free(&tbl);
+        return;
+    }
+    if (axis_config_equal(&cur->tbl, &tbl)) {
+        axis_config_free(&tbl);
+        return;
+    }
+
+    /* 轴数不变，复制时复用 slot 原有数组，不触发 RT 线程可见的重新分配 */
+    r = axis_config_copy(&next->tbl, &tbl);
+    axis_config_free(&tbl);
+    if (r) {
+        set_error(cr, "out of memory");
+        return;
+    }
+    uint32_t gen = ++cr->next_generation;
+    for (unsigned int i = 0; i < cr->mask_words; i++)
+        atomic_store_explicit(&next->moved_mask[i], moved[i], memory_order_relaxed);
+    atomic_store_explicit(&cr->state,
+                          ((uint64_t)gen << 2) | STATE_PENDING | active,
+                          memory_order_release);
+}
+
+static void *watch_thread(void *arg)
+{
+    config_reload_t *cr = arg;
+    _Alignas(struct inotify_event) char buf[4096];
+    struct pollfd fds[2] = {
+        {.fd = cr->inotify_fd, .events = POLLIN},
+        {.fd = cr->stop_fd, .events = POLLIN},
+    };
+
+    for (;;) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        if (fds[1].revents)
+            break;
+        if (!(fds[0].revents & POLLIN))
+            continue;
+
+        ssize_t n = read(cr->inotify_fd, buf, sizeof(buf));
+        if (n <= 0)
+            continue;
+        int hit = 0;
+        for (char *p = buf; p < buf + n;) {
+            struct inotify_event *ev = (struct inotify_event *)p;
+            if (ev->len && !strcmp(ev->name, cr->base))
+                hit = 1;
+            p += sizeof(*ev) + ev->len;
+        }
+        if (hit)
+            reload(cr);
+    }
+    return NULL;
+}
+
+int config_reload_start(const char *path, const axis_config_table_t *initial,
+                        config_reload_policy_t policy, config_reload_t **out)
+{
+    if (!path || !initial || !out || strlen(path) >= PATH_MAX)
+        return -EINVAL;
+
+    config_reload_t *cr = calloc(1, sizeof(*cr));
+    if (!cr)
+        return -ENOMEM;
+    pthread_mutex_init(&cr->err_lock, NULL);
+    cr->policy = policy;
+    cr->inotify_fd = cr->stop_fd = -1;
+    atomic_init(&cr->state, 0);
+    atomic_init(&cr->generation, 0);
+    atomic_init(&cr->event_seq, 0);
+    atomic_init(&cr->policy_reject_seq, 0);
+    atomic_init(&cr->policy_reject, 0);
+
+    /* 两个 slot 各持有一份深拷贝，之后只在原数组上覆盖 */
+    int err = -ENOMEM;
+    cr->mask_words = AXIS_MASK_WORDS(initial->n_axes) ? AXIS_MASK_WORDS(initial->n_axes) : 1;
+    for (int s = 0; s < 2; s++) {
+        cr->slots[s].moved_mask = calloc(cr->mask_words, sizeof(*cr->slots[s].moved_mask));
+        if (!cr->slots[s].moved_mask || axis_config_copy(&cr->slots[s].tbl, initial))
+            goto fail;
+    }
+    cr->axis_ids = calloc(initial->n_axes ? initial->n_axes : 1, sizeof(*cr->axis_ids));
+    if (!cr->axis_ids)
+        goto fail;
+    for (unsigned int i = 0; i < initial->n_axes; i++)
+        cr->axis_ids[i] = initial->axes[i].axis_id;
+
+    strcpy(cr->path, path);
+    const char *slash = strrchr(path, '/');
+    if (slash) {
+        size_t dlen = (size_t)(slash - path);
+        memcpy(cr->dir, path, dlen ? dlen : 1);
+        strncpy(cr->base, slash + 1, sizeof(cr->base) - 1);
+    } else {
+        strcpy(cr->dir, ".");
+        strncpy(cr->base, path, sizeof(cr->base) - 1);
+    }
+
+    cr->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    cr->stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (cr->inotify_fd < 0 || cr->stop_fd < 0) {
+        err = -errno;
+        goto fail;
+    }
+    /* 监视目录而非文件：编辑器常以 "写临时文件 + rename" 方式保存 */
+    if (inotify_add_watch(cr->inotify_fd, cr->dir, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        err = -errno;
+        goto fail;
+    }
+    err = -pthread_create(&cr->thread, NULL, watch_thread, cr);
+    if (err)
+        goto fail;
+
+    *out = cr;
+    return 0;
+
+fail:
+    if (cr->inotify_fd >= 0)
+        close(cr->inotify_fd);
+    if (cr->stop_fd >= 0)
+        close(cr->stop_fd);
+    for (int s = 0; s < 2; s++) {
+        axis_config_free(&cr->slots[s].tbl);
+        free(cr->slots[s].moved_mask);
+    }
+    free(cr->axis_ids);
+    pthread_mutex_destroy(&cr->err_lock);
+    free(cr);
+    return err;
+}
+
+const axis_config_table_t *config_reload_sync(config_reload_t *cr, const uint64_t *enabled_mask)
+{
+    uint64_t w = atomic_load_explicit(&cr->state, memory_order_acquire);
+    unsigned int active = STATE_ACTIVE(w);
+    if (!(w & STATE_PENDING))
+        return &cr->slots[active].tbl;
+
+    config_slot_t *next = &cr->slots[active ^ 1];
+    int conflict = -1;
+    for (unsigned int i = 0; i < cr->mask_words && conflict < 0; i++) {
+        uint64_t hit = atomic_load_explicit(&next->moved_mask[i], memory_order_relaxed) &
+                       enabled_mask[i];
+        if (hit)
+            conflict = (int)(i * 64u + (unsigned int)__builtin_ctzll(hit));
+    }
+
+    if (conflict >= 0 && cr->policy == CONFIG_RELOAD_HOLD) {
+        atomic_fetch_add_explicit(&cr->held_cycles, 1, memory_order_relaxed);
+        return &cr->slots[active].tbl;
+    }
+    /* 清除 pending 与翻转 active 是同一次写入，监视线程不会看到中间状态 */
+    uint64_t to = conflict >= 0 ? w & ~(uint64_t)STATE_PENDING
+                                : (w & ~(uint64_t)(STATE_PENDING | 1u)) | (active ^ 1);
+    if (!atomic_compare_exchange_strong_explicit(&cr->state, &w, to, memory_order_acq_rel,
+                                                 memory_order_relaxed))
+        return &cr->slots[active].tbl;  /* 监视线程正在替换，下个周期再处理 */
+
+    uint32_t gen = (uint32_t)(w >> 2);
+    if (conflict >= 0) {
+        /* 轴映射不允许热加载修改，axis_ids 对任何版本都成立 */
+        atomic_store_explicit(&cr->policy_reject,
+                              ((uint64_t)gen << 32) | (uint32_t)cr->axis_ids[conflict],
+                              memory_order_relaxed);
+        atomic_store_explicit(&cr->policy_reject_seq,
+                              atomic_fetch_add_explicit(&cr->event_seq, 1,
+                                                        memory_order_relaxed) + 1,
+                              memory_order_release);
+        atomic_fetch_add_explicit(&cr->rejected, 1, memory_order_relaxed);
+        return &cr->slots[active].tbl;
+    }
+    atomic_store_explicit(&cr->generation, gen, memory_order_relaxed);
+    atomic_fetch_add_explicit(&cr->applied, 1, memory_order_relaxed);
+    return &next->tbl;
+}
+
+void config_reload_get_status(config_reload_t *cr, config_reload_status_t *st)
+{
+    memset(st, 0, sizeof(*st));
+    uint64_t w = atomic_load_explicit(&cr->state, memory_order_acquire);
+    st->generation = atomic_load_explicit(&cr->generation, memory_order_relaxed);
+    st->applied = atomic_load_explicit(&cr->applied, memory_order_relaxed);
+    st->rejected = atomic_load_explicit(&cr->rejected, memory_order_relaxed);
+    st->held_cycles = atomic_load_explicit(&cr->held_cycles, memory_order_relaxed);
+    st->pending = (w & STATE_PENDING) != 0;
+
+    uint32_t rseq = atomic_load_explicit(&cr->policy_reject_seq, memory_order_acquire);
+    uint64_t reject = atomic_load_explicit(&cr->policy_reject, memory_order_relaxed);
+    pthread_mutex_lock(&cr->err_lock);
+    if (rseq && (int32_t)(rseq - cr->error_seq) > 0)
+        snprintf(st->last_error, sizeof(st->last_error),
+                 "generation %u rejected: axis %d is enabled (policy reject)",
+                 (unsigned int)(reject >> 32), (int)(int32_t)(uint32_t)reject);
+    else
+        memcpy(st->last_error, cr->last_error, sizeof(st->last_error));
+    pthread_mutex_unlock(&cr->err_lock);
+}
+
+void config_reload_stop(config_reload_t *cr)
+{
+    if (!cr)
+        return;
+    uint64_t one = 1;
+    if (write(cr->stop_fd, &one, sizeof(one)) == sizeof(one))
+        pthread_join(cr->thread, NULL);
+    close(cr->inotify_fd);
+    close(cr->stop_fd);
+    for (int s = 0; s < 2; s++) {
+        axis_config_free(&cr->slots[s].tbl);
+        free(cr->slots[s].moved_mask);
+    }
+    free(cr->axis_ids);
+    pthread_mutex_destroy(&cr->err_lock);
+    free(cr);
+}
@@ -0,0 +1,169 @@
+/*
+ * cycle_sched.c
+ *
+ * 周期调度与超时恢复实现，接口说明见 cycle_sched.h。
+ * 调度状态只由周期线程修改；统计量用原子变量，供其他线程读取。
+ */
+
+#include "cycle_sched.h"
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define NSEC_PER_SEC 1000000000ull
+
+struct cycle_sched {
+    cycle_sched_config_t cfg;
+    uint64_t             start_ns;
+    uint64_t             next;      /* 下一个要执行的时隙 */
+    uint64_t             cur;       /* 当前周期的时隙 */
+    unsigned int         burst;     /* 连续补跑的周期数 */
+
+    _Atomic int          clear_req;
+    _Atomic int          safe_state;
+    _Atomic uint64_t     cycles;
+    _Atomic uint64_t     deadline_misses;
+    _Atomic uint64_t     skipped;
+    _Atomic uint64_t     caught_up;
+    _Atomic uint32_t     consecutive_misses;
+    _Atomic uint32_t     max_lateness_ns;
+};
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NSEC_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint64_t slot_ns(const cycle_sched_t *cs, uint64_t k)
+{
+    return cs->start_ns + k * cs->cfg.period_ns;
+}
+
+static void sleep_until_ns(uint64_t t)
+{
+    struct timespec ts = {(time_t)(t / NSEC_PER_SEC), (long)(t % NSEC_PER_SEC)};
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+        ;
+}
+
+int cycle_sched_create(const cycle_sched_config_t *cfg, uint64_t start_ns, cycle_sched_t **out)
+{
+    if (!cfg || !out || !cfg->period_ns || cfg->deadline_ns > cfg->period_ns)
+        return -EINVAL;
+
+    cycle_sched_t *cs = calloc(1, sizeof(*cs));
+    if (!cs)
+        return -ENOMEM;
+    cs->cfg = *cfg;
+    if (!cs->cfg.deadline_ns)
+        cs->cfg.deadline_ns = cs->cfg.period_ns;
+    if (!cs->cfg.max_catchup)
+        cs->cfg.max_catchup = CYCLE_SCHED_DEFAULT_MAX_CATCHUP;
+    cs->start_ns = start_ns;
+    *out = cs;
+    return 0;
+}
+
+void cycle_sched_wait(cycle_sched_t *cs, cycle_tick_t *tick)
+{
+    if (atomic_exchange_explicit(&cs->clear_req, 0, memory_order_relaxed) &&
+        atomic_load_explicit(&cs->safe_state, memory_order_relaxed)) {
+        atomic_store_explicit(&cs->safe_state, 0, memory_order_relaxed);
+        atomic_store_explicit(&cs->consecutive_misses, 0, memory_order_relaxed);
+        diag_ring_push(cs->cfg.diag, DIAG_SAFE_STATE_EXIT, cs->cfg.source, cs->next, 0);
+    }
+
+    uint64_t now = now_ns();
+    uint64_t slot = slot_ns(cs, cs->next);
+    int catchup = 0;
+
+    if (now < slot) {
+        cs->burst = 0;
+        sleep_until_ns(slot);
+    } else {
+        /* lag：已经完整错过的周期数；为 0 表示仍在该时隙内，直接执行 */
+        uint64_t lag = (now - slot) / cs->cfg.period_ns;
+        if (!lag) {
+            cs->burst = 0;
+        } else if (cs->cfg.policy == CYCLE_OVERRUN_CATCHUP &&
+                   cs->burst < cs->cfg.max_catchup) {
+            cs->burst++;
+            catchup = 1;
+            atomic_fetch_add_explicit(&cs->caught_up, 1, memory_order_relaxed);
+            diag_ring_push(cs->cfg.diag, DIAG_CATCHUP, cs->cfg.source, cs->next, (int64_t)lag);
+        } else {
+            /* 丢弃落后的时隙 (含当前已开始的时隙)，在下一个边界重新对齐 */
+            uint64_t skip = lag + 1;
+            cs->burst = 0;
+            cs->next += skip;
+            atomic_fetch_add_explicit(&cs->skipped, skip, memory_order_relaxed);
+            diag_ring_push(cs->cfg.diag, DIAG_CYCLES_SKIPPED, cs->cfg.source, cs->next,
+                           (int64_t)skip);
+            slot = slot_ns(cs, cs->next);
+            sleep_until_ns(slot);
+        }
+    }
+
+    cs->cur = cs->next;
+    tick->cycle = cs->cur;
+    tick->slot_ns = slot;
+    tick->wake_ns = now_ns();
+    tick->catchup = catchup;
+    tick->safe_state = atomic_load_explicit(&cs->safe_state, memory_order_relaxed);
+}
+
+void cycle_sched_done(cycle_sched_t *cs)
+{
+    uint64_t end = now_ns();
+    uint64_t deadline = slot_ns(cs, cs->cur) + cs->cfg.deadline_ns;
+
+    atomic_fetch_add_explicit(&cs->cycles, 1, memory_order_relaxed);
+    cs->next = cs->cur + 1;
+
+    /* 补跑的时隙开始时就已过了截止时间，同样按错过计数 */
+    if (end <= deadline) {
+        atomic_store_explicit(&cs->consecutive_misses, 0, memory_order_relaxed);
+        return;
+    }
+
+    uint64_t late = end - deadline;
+    uint32_t consec = atomic_load_explicit(&cs->consecutive_misses, memory_order_relaxed) + 1;
+    atomic_store_explicit(&cs->consecutive_misses, consec, memory_order_relaxed);
+    atomic_fetch_add_explicit(&cs->deadline_misses, 1, memory_order_relaxed);
+    if (late > atomic_load_explicit(&cs->max_lateness_ns, memory_order_relaxed))
+        atomic_store_explicit(&cs->max_lateness_ns, late > UINT32_MAX ? UINT32_MAX : (uint32_t)late,
+                              memory_order_relaxed);
+    diag_ring_push(cs->cfg.diag, DIAG_DEADLINE_MISS, cs->cfg.source, cs->cur, (int64_t)late);
+
+    if (cs->cfg.safe_after && consec >= cs->cfg.safe_after &&
+        !atomic_load_explicit(&cs->safe_state, memory_order_relaxed)) {
+        atomic_store_explicit(&cs->safe_state, 1, memory_order_relaxed);
+        diag_ring_push(cs->cfg.diag, DIAG_SAFE_STATE_ENTER, cs->cfg.source, cs->cur, consec);
+    }
+}
+
+void cycle_sched_clear_safe(cycle_sched_t *cs)
+{
+    atomic_store_explicit(&cs->clear_req, 1, memory_order_relaxed);
+}
+
+void cycle_sched_get_stats(const cycle_sched_t *cs, cycle_sched_stats_t *st)
+{
+    cycle_sched_t *c = (cycle_sched_t *)cs;
+    st->cycles = atomic_load_explicit(&c->cycles, memory_order_relaxed);
+    st->deadline_misses = atomic_load_explicit(&c->deadline_misses, memory_order_relaxed);
+    st->skipped = atomic_load_explicit(&c->skipped, memory_order_relaxed);
+    st->caught_up = atomic_load_explicit(&c->caught_up, memory_order_relaxed);
+    st->consecutive_misses = atomic_load_explicit(&c->consecutive_misses, memory_order_relaxed);
+    st->max_lateness_ns = atomic_load_explicit(&c->max_lateness_ns, memory_order_relaxed);
+    st->safe_state = atomic_load_explicit(&c->safe_state, memory_order_relaxed);
+}
+
+void cycle_sched_destroy(cycle_sched_t *cs)
+{
+    free(cs);
+}
@@ -0,0 +1,515 @@
+/*
+ * di_edge.c
+ *
+ * 数字量输入边沿检测实现，接口说明见 di_edge.h。
+ *
+ * 周期任务独占 cur[] / prev[] / pend[]，只向 ring 写入有变化的字；环满时变化累积在 pend[]
+ * (上升/下降掩码按位或，周期号与时间戳保留第一次)，之后每周期重试；分发线程独占 ring 的消费端，
+ * 电平、每位的边沿序号与最近事件由 lock 保护 (供 di_edge_wait() / di_edge_level())，
+ * 订阅表由 sub_lock 保护，回调在持有 sub_lock 时调用。
+ */
+
+#define _GNU_SOURCE
+
+#include "di_edge.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "spsc_ring.h"
+
+/* 周期任务 -> 分发线程：一个字在一个周期内的变化 */
+typedef struct {
+    uint32_t word;
+    uint32_t rise;
+    uint32_t fall;
+    uint32_t value;
+    uint64_t cycle;
+    uint64_t time_ns;
+} di_change_t;
+
+typedef struct {
+    unsigned int bit;
+    unsigned int edges;
+    di_edge_fn   fn;
+    void        *arg;
+} di_sub_t;
+
+struct di_edge {
+    unsigned int        n_words;
+    ec_pdo_entry_reg_t *regs;
+    unsigned int       *offsets;
+    uint8_t           **pdo;
+    uint8_t            *width;      /* 8 / 16 / 32 */
+    int                *slave_id;
+    uint16_t           *index;
+
+    /* 周期任务独占 */
+    uint32_t           *cur;
+    uint32_t           *prev;
+    di_change_t        *pend;       /* 环满未写入的累积变化，rise | fall 为 0 表示无 */
+    unsigned int        n_pend;
+    int                 primed;
+    spsc_ring_t        *ring;
+
+    /* 分发线程 */
+    pthread_t           thread;
+    int                 started;
+    uint32_t            poll_ns;
+
+    pthread_mutex_t     lock;
+    pthread_cond_t      cond;
+    int                 running;
+    unsigned int        n_waiters;
+    uint32_t           *level;
+    uint32_t           *rise_seq;   /* 每位的上升沿计数 */
+    uint32_t           *fall_seq;
+    di_edge_event_t    *last_rise;  /* 每位最近一次上升沿 */
+    di_edge_event_t    *last_fall;
+
+    pthread_mutex_t     sub_lock;
+    di_sub_t            subs[DI_EDGE_MAX_SUBS];   /* fn 为 NULL 表示空闲 */
+
+    _Atomic uint64_t    changes;
+    _Atomic uint64_t    edges;
+    _Atomic uint64_t    dropped;
+    _Atomic uint64_t    dispatched;
+};
+
+#define INC(x, n) atomic_fetch_add_explicit(&(x), (n), memory_order_relaxed)
+#define LOAD(x)   atomic_load_explicit(&(x), memory_order_relaxed)
+
+static int edge_fail(char *err, size_t err_len, int ret, const char *fmt, ...)
+{
+    if (err && err_len) {
+        va_list ap;
+        va_start(ap, fmt);
+        vsnprintf(err, err_len, fmt, ap);
+        va_end(ap);
+    }
+    return ret;
+}
+
+/* 在输入 PDO 中查找对象；找到返回 0 */
+static int input_lookup(const ec_sync_info_t *syncs, uint16_t index, uint8_t *subindex,
+                        uint8_t *bits)
+{
+    for (const ec_sync_info_t *sm = syncs; sm && sm->index != 0xff; sm++) {
+        if (sm->dir != EC_DIR_INPUT)
+            continue;
+        for (unsigned int p = 0; p < sm->n_pdos; p++) {
+            const ec_pdo_info_t *pdo = &sm->pdos[p];
+            for (unsigned int e = 0; e < pdo->n_entries; e++) {
+                if (pdo->entries[e].index == index) {
+                    *subindex = pdo->entries[e].subindex;
+                    *bits = pdo->entries[e].bit_length;
+                    return 0;
+                }
+            }
+        }
+    }
+    return -1;
+}
+
+/* --- 分发线程 --- */
+
+static void dispatch(di_edge_t *d, const di_change_t *c)
+{
+    unsigned int base = c->word * 32;
+    di_edge_event_t ev = {.cycle = c->cycle, .time_ns = c->time_ns};
+
+    /*
+     * 按 {上升, 下降, 上升, 下降} 的顺序展开掩码。积压合并的记录中同一位可能同时有上升与
+     * 下降，把与当前电平一致的那个放到后两组，保证每位最后分发的边沿与电平相符
+     */
+    uint32_t both = c->rise & c->fall;
+    uint32_t order[4] = {
+        c->rise & ~(both & c->value), c->fall & ~(both & ~c->value),
+        both & c->value, both & ~c->value,
+    };
+
+    pthread_mutex_lock(&d->lock);
+    d->level[c->word] = c->value;
+    for (unsigned int k = 0; k < 4; k++) {
+        ev.edge = (k & 1) ? DI_EDGE_FALLING : DI_EDGE_RISING;
+        for (uint32_t m = order[k]; m; m &= m - 1) {
+            unsigned int bit = base + (unsigned int)__builtin_ctz(m);
+            ev.bit = bit;
+            if (k & 1) {
+                d->last_fall[bit] = ev;
+                d->fall_seq[bit]++;
+            } else {
+                d->last_rise[bit] = ev;
+                d->rise_seq[bit]++;
+            }
+        }
+    }
+    if (d->n_waiters)
+        pthread_cond_broadcast(&d->cond);
+    pthread_mutex_unlock(&d->lock);
+
+    pthread_mutex_lock(&d->sub_lock);
+    for (unsigned int k = 0; k < 4; k++) {
+        uint32_t mask = order[k];
+        ev.edge = (k & 1) ? DI_EDGE_FALLING : DI_EDGE_RISING;
+        for (; mask; mask &= mask - 1) {
+            ev.bit = base + (unsigned int)__builtin_ctz(mask);
+            for (unsigned int s = 0; s < DI_EDGE_MAX_SUBS; s++) {
+                const di_sub_t *sub = &d->subs[s];
+                if (sub->fn && sub->bit == ev.bit && (sub->edges & ev.edge))
+                    sub->fn(&ev, sub->arg);
+            }
+        }
+    }
+    pthread_mutex_unlock(&d->sub_lock);
+    INC(d->dispatched, (uint64_t)(__builtin_popcount(c->rise) + __builtin_popcount(c->fall)));
+}
+
+static void *dispatch_thread(void *arg)
+{
+    di_edge_t *d = arg;
+    struct timespec ts = {.tv_sec = 0, .tv_nsec = d->poll_ns};
+    for (;;) {
+        pthread_mutex_lock(&d->lock);
+        int running = d->running;
+        pthread_mutex_unlock(&d->lock);
+        if (!running)
+            break;
+
+        di_change_t c;
+        while (spsc_ring_pop(d->ring, &c))
+            dispatch(d, &c);
+        nanosleep(&ts, NULL);
+    }
+    return NULL;
+}
+
+/* --- 周期任务 --- */
+
+void di_edge_cycle(di_edge_t *d, uint64_t cycle, uint64_t time_ns)
+{
+    if (!d || !d->pdo[0])
+        return;
+
+    unsigned int n = d->n_words;
+    uint32_t *cur = d->cur, *prev = d->prev;
+    for (unsigned int w = 0; w < n; w++) {
+        const uint8_t *p = d->pdo[w];
+        switch (d->width[w]) {
+        case 8:  cur[w] = EC_READ_U8(p);  break;
+        case 16: cur[w] = EC_READ_U16(p); break;
+        default: cur[w] = EC_READ_U32(p); break;
+        }
+    }
+    if (!d->primed) {
+        memcpy(prev, cur, n * sizeof(*cur));
+        d->primed = 1;
+        return;
+    }
+
+    /* 绝大多数周期没有变化，也没有待重试的记录，只做一遍异或归约 */
+    uint32_t any = 0;
+    for (unsigned int w = 0; w < n; w++)
+        any |= cur[w] ^ prev[w];
+    if (!any && !d->n_pend)
+        return;
+
+    for (unsigned int w = 0; w < n; w++) {
+        uint32_t diff = cur[w] ^ prev[w];
+        di_change_t *c = &d->pend[w];
+        int was_pending = (c->rise | c->fall) != 0;
+        if (!diff && !was_pending)
+            continue;
+        if (!was_pending) {
+            c->word = w;
+            c->cycle = cycle;
+            c->time_ns = time_ns;
+            d->n_pend++;
+        }
+        /*
+         * 环满时变化按位累积，下一周期连同新变化一起重试：同一位在积压期间的多次脉冲
+         * 合并为一次上升 + 一次下降，周期号与时间戳为第一次检测到的周期
+         */
+        c->rise |= diff & cur[w];
+        c->fall |= diff & prev[w];
+        c->value = cur[w];
+        prev[w] = cur[w];
+        if (spsc_ring_push(d->ring, c)) {
+            INC(d->dropped, 1);
+            continue;
+        }
+        INC(d->changes, 1);
+        INC(d->edges, (uint64_t)(__builtin_popcount(c->rise) + __builtin_popcount(c->fall)));
+        c->rise = c->fall = 0;
+        d->n_pend--;
+    }
+}
+
+/* --- 接口 --- */
+
+int di_edge_create(const di_config_t *words, unsigned int n,
+                   const axis_slave_desc_t *slaves, unsigned int n_slaves, uint32_t cycle_us,
+                   di_edge_t **out, char *err, size_t err_len)
+{
+    if (!out || (n && !words) || !cycle_us)
+        return -EINVAL;
+
+    di_edge_t *d = calloc(1, sizeof(*d));
+    if (!d)
+        return -ENOMEM;
+    unsigned int m = n ? n : 1;
+    d->n_words = n;
+    d->regs = calloc(n + 1, sizeof(*d->regs));
+    d->offsets = calloc(m, sizeof(*d->offsets));
+    d->pdo = calloc(m, sizeof(*d->pdo));
+    d->width = calloc(m, sizeof(*d->width));
+    d->slave_id = calloc(m, sizeof(*d->slave_id));
+    d->index = calloc(m, sizeof(*d->index));
+    d->cur = calloc(m, sizeof(*d->cur));
+    d->prev = calloc(m, sizeof(*d->prev));
+    d->pend = calloc(m, sizeof(*d->pend));
+    d->level = calloc(m, sizeof(*d->level));
+    d->rise_seq = calloc((size_t)m * 32, sizeof(*d->rise_seq));
+    d->fall_seq = calloc((size_t)m * 32, sizeof(*d->fall_seq));
+    d->last_rise = calloc((size_t)m * 32, sizeof(*d->last_rise));
+    d->last_fall = calloc((size_t)m * 32, sizeof(*d->last_fall));
+    if (!d->regs || !d->offsets || !d->pdo || !d->width || !d->slave_id || !d->index ||
+        !d->cur || !d->prev || !d->pend || !d->level || !d->rise_seq || !d->fall_seq ||
+        !d->last_rise || !d->last_fall) {
+        di_edge_destroy(d);
+        return -ENOMEM;
+    }
+
+    for (unsigned int i = 0; i < n; i++) {
+        const di_config_t *c = &words[i];
+        const axis_slave_desc_t *sd = NULL;
+        for (unsigned int s = 0; s < n_slaves && !sd; s++) {
+            if (slaves[s].position == c->slave_id)
+                sd = &slaves[s];
+        }
+        uint8_t sub = 0, bits = 0;
+        int r = 0;
+        if (!sd)
+            r = edge_fail(err, err_len, -EINVAL, "digital input 0x%04X: slave %d not on bus",
+                          c->index, c->slave_id);
+        else if (input_lookup(sd->syncs, c->index, &sub, &bits))
+            r = edge_fail(err, err_len, -EINVAL,
+                          "digital input 0x%04X not an input in PDO map of slave %d", c->index,
+                          c->slave_id);
+        else if (bits != 8 && bits != 16 && bits != 32)
+            r = edge_fail(err, err_len, -EINVAL,
+                          "digital input 0x%04X on slave %d is %u bits, expected 8/16/32",
+                          c->index, c->slave_id, bits);
+        if (r) {
+            di_edge_destroy(d);
+            return r;
+        }
+        d->width[i] = bits;
+        d->slave_id[i] = c->slave_id;
+        d->index[i] = c->index;
+
+        ec_pdo_entry_reg_t *reg = &d->regs[i];
+        reg->alias = sd->alias;
+        reg->position = sd->position;
+        reg->vendor_id = sd->vendor_id;
+        reg->product_code = sd->product_code;
+        reg->index = c->index;
+        reg->subindex = sub;
+        reg->offset = &d->offsets[i];
+        reg->bit_position = NULL;
+    }
+
+    int r = spsc_ring_create(DI_EDGE_RING_CAPACITY, sizeof(di_change_t), &d->ring);
+    if (r) {
+        di_edge_destroy(d);
+        return r;
+    }
+    pthread_condattr_t ca;
+    pthread_condattr_init(&ca);
+    pthread_condattr_setclock(&ca, CLOCK_MONOTONIC);
+    pthread_cond_init(&d->cond, &ca);
+    pthread_condattr_destroy(&ca);
+    pthread_mutex_init(&d->lock, NULL);
+    pthread_mutex_init(&d->sub_lock, NULL);
+    d->poll_ns = cycle_us * 1000u;
+    atomic_init(&d->changes, 0);
+    atomic_init(&d->edges, 0);
+    atomic_init(&d->dropped, 0);
+    atomic_init(&d->dispatched, 0);
+
+    d->running = 1;
+    r = pthread_create(&d->thread, NULL, dispatch_thread, d);
+    if (r) {
+        d->running = 0;
+        di_edge_destroy(d);
+        return -r;
+    }
+    d->started = 1;
+    *out = d;
+    return 0;
+}
+
+const ec_pdo_entry_reg_t *di_edge_regs(const di_edge_t *d)
+{
+    return d->regs;
+}
+
+int di_edge_bind(di_edge_t *d, uint8_t *domain_pd)
+{
+    if (!d || !domain_pd)
+        return -EINVAL;
+    for (unsigned int i = 0; i < d->n_words; i++)
+        d->pdo[i] = domain_pd + d->offsets[i];
+    return 0;
+}
+
+int di_edge_bit(const di_edge_t *d, int slave_id, uint16_t index, unsigned int bit)
+{
+    for (unsigned int i = 0; i < d->n_words; i++) {
+        if (d->slave_id[i] == slave_id && d->index[i] == index)
+            return bit < d->width[i] ? (int)(i * 32 + bit) : -ENOENT;
+    }
+    return -ENOENT;
+}
+
+int di_edge_level(di_edge_t *d, unsigned int bit)
+{
+    if (bit / 32 >= d->n_words)
+        return -EINVAL;
+    pthread_mutex_lock(&d->lock);
+    int v = (int)(d->level[bit / 32] >> (bit % 32)) & 1;
+    pthread_mutex_unlock(&d->lock);
+    return v;
+}
+
+int di_edge_subscribe(di_edge_t *d, unsigned int bit, unsigned int edges, di_edge_fn fn,
+                      void *arg)
+{
+    if (!d || !fn || !(edges & DI_EDGE_BOTH) || bit / 32 >= d->n_words)
+        return -EINVAL;
+    int id = -ENOSPC;
+    pthread_mutex_lock(&d->sub_lock);
+    for (unsigned int s = 0; s < DI_EDGE_MAX_SUBS; s++) {
+        if (!d->subs[s].fn) {
+            d->subs[s] = (di_sub_t){.bit = bit, .edges = edges, .fn = fn, .arg = arg};
+            id = (int)s;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&d->sub_lock);
+    return id;
+}
+
+void di_edge_unsubscribe(di_edge_t *d, int id)
+{
+    if (!d || id < 0 || id >= DI_EDGE_MAX_SUBS)
+        return;
+    pthread_mutex_lock(&d->sub_lock);
+    d->subs[id].fn = NULL;
+    pthread_mutex_unlock(&d->sub_lock);
+}
+
+int di_edge_wait(di_edge_t *d, unsigned int bit, unsigned int edges, int timeout_ms,
+                 di_edge_event_t *ev)
+{
+    if (!d || !(edges & DI_EDGE_BOTH) || bit / 32 >= d->n_words)
+        return -EINVAL;
+
+    struct timespec deadline;
+    if (timeout_ms >= 0) {
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+    }
+
+    pthread_mutex_lock(&d->lock);
+    uint32_t r0 = d->rise_seq[bit], f0 = d->fall_seq[bit];
+    int r = 0;
+    d->n_waiters++;
+    for (;;) {
+        const di_edge_event_t *hit = NULL;
+        if ((edges & DI_EDGE_RISING) && d->rise_seq[bit] != r0)
+            hit = &d->last_rise[bit];
+        if ((edges & DI_EDGE_FALLING) && d->fall_seq[bit] != f0 &&
+            (!hit || d->last_fall[bit].cycle > hit->cycle))
+            hit = &d->last_fall[bit];
+        if (hit) {
+            if (ev)
+                *ev = *hit;
+            break;
+        }
+        if (!d->running) {
+            r = -ESHUTDOWN;
+            break;
+        }
+        if (r == ETIMEDOUT) {
+            r = -ETIMEDOUT;
+            break;
+        }
+        if (timeout_ms >= 0)
+            r = pthread_cond_timedwait(&d->cond, &d->lock, &deadline);
+        else
+            pthread_cond_wait(&d->cond, &d->lock);
+    }
+    if (r > 0)
+        r = 0;
+    if (!--d->n_waiters && !d->running)
+        pthread_cond_broadcast(&d->cond);
+    pthread_mutex_unlock(&d->lock);
+    return r;
+}
+
+void di_edge_get_stats(const di_edge_t *d, di_edge_stats_t *st)
+{
+    di_edge_t *m = (di_edge_t *)d;
+    st->changes = LOAD(m->changes);
+    st->edges = LOAD(m->edges);
+    st->dropped = LOAD(m->dropped);
+    st->dispatched = LOAD(m->dispatched);
+}
+
+void di_edge_destroy(di_edge_t *d)
+{
+    if (!d)
+        return;
+    if (d->ring) {
+        /* 等待者先以 -ESHUTDOWN 返回，再停止分发线程 */
+        pthread_mutex_lock(&d->lock);
+        d->running = 0;
+        pthread_cond_broadcast(&d->cond);
+        while (d->n_waiters)
+            pthread_cond_wait(&d->cond, &d->lock);
+        pthread_mutex_unlock(&d->lock);
+        if (d->started)
+            pthread_join(d->thread, NULL);
+        pthread_mutex_destroy(&d->sub_lock);
+        pthread_mutex_destroy(&d->lock);
+        pthread_cond_destroy(&d->cond);
+        spsc_ring_destroy(d->ring);
+    }
+    free(d->regs);
+    free(d->offsets);
+    free(d->pdo);
+    free(d->width);
+    free(d->slave_id);
+    free(d->index);
+    free(d->cur);
+    free(d->prev);
+    free(d->pend);
+    free(d->level);
+    free(d->rise_seq);
+    free(d->fall_seq);
+    free(d->last_rise);
+    free(d->last_fall);
+    free(d);
+}
@@ -0,0 +1,145 @@
+/*
+ * diag_ring.c
+ *
+ * 有界 MPSC 环，接口说明见 diag_ring.h。
+ *
+ * 每个槽带序号 seq：seq == pos 表示空闲可写，seq == pos + 1 表示已写入待读。
+ * 生产者 CAS 推进 head 领取槽位，写完后以 release 存 seq；
+ * 消费者看到 seq == tail + 1 才读取，读完把 seq 置为 tail + capacity 交还给下一轮。
+ */
+
+#include "diag_ring.h"
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef struct {
+    _Atomic uint64_t seq;
+    diag_event_t     ev;
+} diag_slot_t;
+
+struct diag_ring {
+    _Alignas(64) _Atomic uint64_t head;     /* 生产者 */
+    _Alignas(64) uint64_t         tail;     /* 消费者独占 */
+    _Alignas(64) _Atomic uint64_t dropped;
+    uint64_t                      mask;
+    diag_slot_t                  *slots;
+};
+
+int diag_ring_create(unsigned int capacity, diag_ring_t **out)
+{
+    if (!out || !capacity || capacity > (1u << 20))
+        return -EINVAL;
+    uint64_t cap = 1;
+    while (cap < capacity)
+        cap <<= 1;
+
+    diag_ring_t *r = aligned_alloc(64, sizeof(*r));
+    if (!r)
+        return -ENOMEM;
+    r->slots = calloc(cap, sizeof(*r->slots));
+    if (!r->slots) {
+        free(r);
+        return -ENOMEM;
+    }
+    for (uint64_t i = 0; i < cap; i++)
+        atomic_init(&r->slots[i].seq, i);
+    atomic_init(&r->head, 0);
+    atomic_init(&r->dropped, 0);
+    r->tail = 0;
+    r->mask = cap - 1;
+    *out = r;
+    return 0;
+}
+
+int diag_ring_push(diag_ring_t *r, diag_code_t code, uint16_t source, uint64_t cycle,
+                   int64_t value)
+{
+    return diag_ring_push_detail(r, code, source, 0, cycle, value);
+}
+
+int diag_ring_push_detail(diag_ring_t *r, diag_code_t code, uint16_t source, uint32_t detail,
+                          uint64_t cycle, int64_t value)
+{
+    if (!r)
+        return 0;
+
+    diag_slot_t *s;
+    uint64_t pos = atomic_load_explicit(&r->head, memory_order_relaxed);
+    for (;;) {
+        s = &r->slots[pos & r->mask];
+        uint64_t seq = atomic_load_explicit(&s->seq, memory_order_acquire);
+        int64_t dif = (int64_t)(seq - pos);
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&r->head, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed))
+                break;
+        } else if (dif < 0) {
+            atomic_fetch_add_explicit(&r->dropped, 1, memory_order_relaxed);
+            return -ENOSPC;
+        } else {
+            pos = atomic_load_explicit(&r->head, memory_order_relaxed);
+        }
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    s->ev.timestamp_ns = (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+    s->ev.cycle = cycle;
+    s->ev.value = value;
+    s->ev.code = (uint16_t)code;
+    s->ev.source = source;
+    s->ev.detail = detail;
+    atomic_store_explicit(&s->seq, pos + 1, memory_order_release);
+    return 0;
+}
+
+int diag_ring_pop(diag_ring_t *r, diag_event_t *ev)
+{
+    diag_slot_t *s = &r->slots[r->tail & r->mask];
+    if (atomic_load_explicit(&s->seq, memory_order_acquire) != r->tail + 1)
+        return 0;
+    *ev = s->ev;
+    atomic_store_explicit(&s->seq, r->tail + r->mask + 1, memory_order_release);
+    r->tail++;
+    return 1;
+}
+
+uint64_t diag_ring_dropped(const diag_ring_t *r)
+{
+    return atomic_load_explicit(&((diag_ring_t *)r)->dropped, memory_order_relaxed);
+}
+
+const char *diag_code_name(uint16_t code)
+{
+    switch (code) {
+    case DIAG_DEADLINE_MISS:      return "deadline_miss";
+    case DIAG_CYCLES_SKIPPED:     return "cycles_skipped";
+    case DIAG_CATCHUP:            return "catchup";
+    case DIAG_SAFE_STATE_ENTER:   return "safe_state_enter";
+    case DIAG_SAFE_STATE_EXIT:    return "safe_state_exit";
+    case DIAG_WKC_MISMATCH:       return "wkc_mismatch";
+    case DIAG_WKC_RESTORED:       return "wkc_restored";
+    case DIAG_FRAME_LOST:         return "frame_lost";
+    case DIAG_LINK_DOWN:          return "link_down";
+    case DIAG_LINK_UP:            return "link_up";
+    case DIAG_SLAVES_RESPONDING:  return "slaves_responding";
+    case DIAG_MASTER_AL_STATE:    return "master_al_state";
+    case DIAG_SLAVE_STATE:        return "slave_state";
+    case DIAG_ANALOG_HIGH:        return "analog_high";
+    case DIAG_ANALOG_LOW:         return "analog_low";
+    case DIAG_ANALOG_NORMAL:      return "analog_normal";
+    default:                      return "unknown";
+    }
+}
+
+void diag_ring_destroy(diag_ring_t *r)
+{
+    if (!r)
+        return;
+    free(r->slots);
+    free(r);
+}
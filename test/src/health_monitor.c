@@ -0,0 +1,247 @@
+/*
+ * health_monitor.c
+ *
+ * 总线健康监视实现，接口说明见 health_monitor.h。
+ * 边沿判定用的 "上次状态" 只由周期线程访问；对外的计数器为原子变量 (relaxed)。
+ */
+
+#include "health_monitor.h"
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+typedef struct {
+    ec_domain_t     *domain;
+    ec_wc_state_t    last;      /* 上周期的 wc_state */
+    uint64_t         ok_run;    /* 连续 COMPLETE 的周期数 */
+
+    _Atomic uint32_t wkc;
+    _Atomic uint32_t expected;
+    _Atomic uint32_t wc_state;
+    _Atomic uint64_t mismatches;
+    _Atomic uint64_t lost;
+    _Atomic uint32_t mismatch_events;
+    _Atomic uint32_t lost_events;
+} domain_mon_t;
+
+typedef struct {
+    ec_slave_config_t *sc;
+    uint16_t           position;
+    int                seen;
+
+    _Atomic uint32_t   packed;  /* online << 8 | operational << 4 | al_state */
+    _Atomic uint32_t   state_changes;
+    _Atomic uint32_t   offline_events;
+} slave_mon_t;
+
+struct health_monitor {
+    ec_master_t     *master;
+    diag_ring_t     *diag;
+    uint16_t         source;
+    unsigned int     n_domains;
+    domain_mon_t     domains[HEALTH_MAX_DOMAINS];
+    unsigned int     n_slaves;
+    unsigned int     next_slave;  /* 轮询位置 */
+    slave_mon_t     *slaves;
+
+    int              master_seen;
+    _Atomic uint64_t cycles;
+    _Atomic uint32_t responding;
+    _Atomic uint32_t al_states;
+    _Atomic uint32_t link_up;
+    _Atomic uint32_t link_down_events;
+    _Atomic uint32_t responding_changes;
+    _Atomic uint32_t al_state_changes;
+};
+
+#define LOAD(x)     atomic_load_explicit(&(x), memory_order_relaxed)
+#define STORE(x, v) atomic_store_explicit(&(x), (v), memory_order_relaxed)
+#define INC(x)      atomic_fetch_add_explicit(&(x), 1, memory_order_relaxed)
+
+int health_monitor_create(const health_monitor_config_t *cfg, health_monitor_t **out)
+{
+    if (!cfg || !out || !cfg->master || cfg->n_domains > HEALTH_MAX_DOMAINS ||
+        (cfg->n_domains && !cfg->domains) || (cfg->n_slaves && (!cfg->slaves || !cfg->slave_pos)))
+        return -EINVAL;
+
+    health_monitor_t *hm = calloc(1, sizeof(*hm));
+    if (!hm)
+        return -ENOMEM;
+    hm->slaves = calloc(cfg->n_slaves ? cfg->n_slaves : 1, sizeof(*hm->slaves));
+    if (!hm->slaves) {
+        free(hm);
+        return -ENOMEM;
+    }
+    hm->master = cfg->master;
+    hm->diag = cfg->diag;
+    hm->source = cfg->source;
+    hm->n_domains = cfg->n_domains;
+    for (unsigned int i = 0; i < cfg->n_domains; i++) {
+        hm->domains[i].domain = cfg->domains[i];
+        hm->domains[i].last = EC_WC_COMPLETE;
+        atomic_init(&hm->domains[i].wc_state, EC_WC_COMPLETE);
+    }
+    hm->n_slaves = cfg->n_slaves;
+    for (unsigned int i = 0; i < cfg->n_slaves; i++) {
+        hm->slaves[i].sc = cfg->slaves[i];
+        hm->slaves[i].position = cfg->slave_pos[i];
+    }
+    atomic_init(&hm->link_up, 1);
+    *out = hm;
+    return 0;
+}
+
+static void check_domain(health_monitor_t *hm, unsigned int i, uint64_t cycle)
+{
+    domain_mon_t *d = &hm->domains[i];
+    ec_domain_state_t ds;
+    if (ecrt_domain_state(d->domain, &ds))
+        return;
+
+    STORE(d->wkc, ds.working_counter);
+    STORE(d->wc_state, ds.wc_state);
+    switch (ds.wc_state) {
+    case EC_WC_COMPLETE:
+        STORE(d->expected, ds.working_counter);
+        if (d->last != EC_WC_COMPLETE)
+            diag_ring_push_detail(hm->diag, DIAG_WKC_RESTORED, hm->source, i, cycle,
+                                  ds.working_counter);
+        d->ok_run++;
+        break;
+    case EC_WC_INCOMPLETE:
+        INC(d->mismatches);
+        if (d->last != EC_WC_INCOMPLETE) {
+            INC(d->mismatch_events);
+            diag_ring_push_detail(hm->diag, DIAG_WKC_MISMATCH, hm->source, i, cycle,
+                                  ds.working_counter);
+        }
+        d->ok_run = 0;
+        break;
+    default:
+        INC(d->lost);
+        if (d->last != EC_WC_ZERO) {
+            INC(d->lost_events);
+            diag_ring_push_detail(hm->diag, DIAG_FRAME_LOST, hm->source, i, cycle,
+                                  (int64_t)d->ok_run);
+        }
+        d->ok_run = 0;
+        break;
+    }
+    d->last = ds.wc_state;
+}
+
+static void check_master(health_monitor_t *hm, uint64_t cycle)
+{
+    ec_master_state_t ms;
+    if (ecrt_master_state(hm->master, &ms))
+        return;
+
+    uint32_t link = ms.link_up;
+    if (link != LOAD(hm->link_up)) {
+        STORE(hm->link_up, link);
+        if (!link)
+            INC(hm->link_down_events);
+        diag_ring_push(hm->diag, link ? DIAG_LINK_UP : DIAG_LINK_DOWN, hm->source, cycle, 0);
+    }
+    if (ms.slaves_responding != LOAD(hm->responding) || !hm->master_seen) {
+        if (hm->master_seen)
+            INC(hm->responding_changes);
+        STORE(hm->responding, ms.slaves_responding);
+        diag_ring_push(hm->diag, DIAG_SLAVES_RESPONDING, hm->source, cycle,
+                       ms.slaves_responding);
+    }
+    if (ms.al_states != LOAD(hm->al_states) || !hm->master_seen) {
+        if (hm->master_seen)
+            INC(hm->al_state_changes);
+        STORE(hm->al_states, ms.al_states);
+        diag_ring_push(hm->diag, DIAG_MASTER_AL_STATE, hm->source, cycle, ms.al_states);
+    }
+    hm->master_seen = 1;
+}
+
+static void check_slave(health_monitor_t *hm, uint64_t cycle)
+{
+    slave_mon_t *s = &hm->slaves[hm->next_slave];
+    if (++hm->next_slave == hm->n_slaves)
+        hm->next_slave = 0;
+
+    ec_slave_config_state_t ss;
+    if (ecrt_slave_config_state(s->sc, &ss))
+        return;
+
+    uint32_t packed = (uint32_t)ss.online << 8 | (uint32_t)ss.operational << 4 | ss.al_state;
+    uint32_t old = LOAD(s->packed);
+    if (s->seen && packed == old)
+        return;
+    if (s->seen) {
+        INC(s->state_changes);
+        if ((old >> 8) && !ss.online)
+            INC(s->offline_events);
+    }
+    s->seen = 1;
+    STORE(s->packed, packed);
+    diag_ring_push_detail(hm->diag, DIAG_SLAVE_STATE, hm->source, s->position, cycle, packed);
+}
+
+void health_monitor_cycle(health_monitor_t *hm, uint64_t cycle)
+{
+    INC(hm->cycles);
+    for (unsigned int i = 0; i < hm->n_domains; i++)
+        check_domain(hm, i, cycle);
+    check_master(hm, cycle);
+    if (hm->n_slaves)
+        check_slave(hm, cycle);
+}
+
+void health_monitor_master_stats(const health_monitor_t *hm, health_master_stats_t *st)
+{
+    health_monitor_t *h = (health_monitor_t *)hm;
+    st->cycles = LOAD(h->cycles);
+    st->slaves_responding = LOAD(h->responding);
+    st->al_states = (uint8_t)LOAD(h->al_states);
+    st->link_up = (uint8_t)LOAD(h->link_up);
+    st->link_down_events = LOAD(h->link_down_events);
+    st->responding_changes = LOAD(h->responding_changes);
+    st->al_state_changes = LOAD(h->al_state_changes);
+}
+
+int health_monitor_domain_stats(const health_monitor_t *hm, unsigned int i,
+                                health_domain_stats_t *st)
+{
+    if (i >= hm->n_domains)
+        return -EINVAL;
+    domain_mon_t *d = (domain_mon_t *)&hm->domains[i];
+    st->working_counter = LOAD(d->wkc);
+    st->expected_wkc = LOAD(d->expected);
+    st->wkc_mismatches = LOAD(d->mismatches);
+    st->lost_frames = LOAD(d->lost);
+    st->mismatch_events = LOAD(d->mismatch_events);
+    st->lost_events = LOAD(d->lost_events);
+    st->wc_state = (uint8_t)LOAD(d->wc_state);
+    return 0;
+}
+
+int health_monitor_slave_stats(const health_monitor_t *hm, unsigned int i,
+                               health_slave_stats_t *st)
+{
+    if (i >= hm->n_slaves)
+        return -EINVAL;
+    slave_mon_t *s = &hm->slaves[i];
+    uint32_t packed = LOAD(s->packed);
+    st->position = s->position;
+    st->online = (uint8_t)(packed >> 8);
+    st->operational = (uint8_t)((packed >> 4) & 1);
+    st->al_state = (uint8_t)(packed & 0xF);
+    st->state_changes = LOAD(s->state_changes);
+    st->offline_events = LOAD(s->offline_events);
+    return 0;
+}
+
+void health_monitor_destroy(health_monitor_t *hm)
+{
+    if (!hm)
+        return;
+    free(hm->slaves);
+    free(hm);
+}
@@ -0,0 +1,824 @@
+/*
+ * master_group.c
+ *
+ * 多主站周期调度实现，接口说明见 master_group.h。
+ *
+ * 设定值帧状态 tag = ((cycle + 1) << 2) | state (0 表示从未使用)：
+ *   WRITING   发布线程正在写入
+ *   READY     已写完，等待第 cycle 周期
+ *   ACCEPTED  第 cycle 周期已采纳，所有主站使用该帧
+ *   EXPIRED   第 cycle 周期开始时尚未就绪，所有主站沿用上一帧
+ * READY -> ACCEPTED 与 WRITING/旧帧 -> EXPIRED 都由周期线程 CAS 完成，
+ * 发布线程只能从更早的周期 CAS 到 WRITING、从 WRITING CAS 到 READY，
+ * 因此第 cycle 周期的结论只会被决定一次。
+ * 发布线程复用槽位前确认每个主站都已过了槽中帧的周期 (taken)，落后的主站
+ * 总能看到该帧的结论，不会在其他主站已采纳时自己判定为过期。
+ */
+
+#define _GNU_SOURCE
+
+#include "master_group.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define NSEC_PER_SEC 1000000000ull
+#define START_LEAD_NS 10000000ull   /* 启动到第 0 周期的提前量 */
+#define CIA402_CW_QUICK_STOP 0x0002 /* 控制字 Quick Stop 命令 */
+
+#define FRAME_TAG(cycle, state) ((((uint64_t)(cycle) + 1) << 2) | (state))
+
+enum {
+    FRAME_WRITING = 0,
+    FRAME_READY,
+    FRAME_ACCEPTED,
+    FRAME_EXPIRED,
+};
+
+typedef struct {
+    _Alignas(64) _Atomic uint64_t tag;
+    double *pos;                      /* 全局轴下标 */
+} setpoint_frame_t;
+
+typedef struct {
+    master_member_t      pub;
+    struct master_group *group;
+    axis_config_table_t  view;        /* 指向全局配置中本主站的区间，不拥有内存 */
+    double              *buf[2];      /* 设定值双缓冲，pub.setpoints 指向其中之一 */
+    uint64_t            *mask;
+    cycle_sched_t       *sched;
+    health_monitor_t    *health;
+    ec_slave_config_t  **sc;          /* 与总线布局的从站一一对应 */
+    uint16_t            *sc_pos;
+    pthread_t            thread;
+    int                  started;
+    telemetry_shm_t     *tlm;          /* 本主站遥测段，未启用时为 NULL */
+    telemetry_stats_t    tlm_stats;    /* 周期线程独占 */
+    _Atomic uint32_t     applied_gen;  /* 已应用到本主站的热加载版本 */
+    _Atomic uint64_t     taken;        /* 已取过帧的最近周期 + 1，0 表示尚未运行 */
+
+    _Atomic uint64_t     stale_frames;
+    _Atomic uint32_t     wake_latency_max_ns;
+    _Atomic uint32_t     exec_max_ns;
+} member_impl_t;
+
+struct master_group {
+    const axis_config_table_t *cfg;
+    master_cycle_fn            fn;
+    void                      *arg;
+    unsigned int               n_members;
+    member_impl_t              members[AXIS_CONFIG_MAX_MASTERS];
+
+    uint64_t                   period_ns;
+    uint64_t                   epoch_ns;
+    _Atomic int                running;
+    diag_ring_t               *diag;
+
+    setpoint_frame_t           frames[MASTER_GROUP_FRAMES];
+
+    /*
+     * 热加载：各主站每周期把本主站轴的使能位写入 enabled (全局下标)，第 0 个主站线程
+     * 用它调用 config_reload_sync()。切换后发布 live / live_cycle，再递增 live_gen；
+     * 所有主站应用完当前版本之前不再调用 sync，因此被换下的表不会在被读时复用。
+     */
+    config_reload_t                    *reload;
+    _Atomic uint64_t                   *enabled;
+    uint64_t                           *enabled_snap;   /* 第 0 个主站线程独占 */
+    const axis_config_table_t          *live;
+    uint64_t                            live_cycle;     /* 各主站从该周期起应用 live */
+    _Atomic uint32_t                    live_gen;
+};
+
+static int group_fail(char *err, size_t err_len, int ret, const char *fmt, ...)
+{
+    if (err && err_len) {
+        va_list ap;
+        va_start(ap, fmt);
+        vsnprintf(err, err_len, fmt, ap);
+        va_end(ap);
+    }
+    return ret;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NSEC_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+static void atomic_max_u32(_Atomic uint32_t *v, uint32_t x)
+{
+    if (x > atomic_load_explicit(v, memory_order_relaxed))
+        atomic_store_explicit(v, x, memory_order_relaxed);
+}
+
+/*
+ * 第 k 周期取帧：决定采纳或过期，采纳时把本主站区间复制到 dst。
+ * 返回 1 表示 dst 中是第 k 周期的设定值。
+ */
+static int take_frame(master_group_t *g, uint64_t k, double *dst, unsigned int first,
+                      unsigned int count)
+{
+    setpoint_frame_t *f = &g->frames[k % MASTER_GROUP_FRAMES];
+    uint64_t t = atomic_load_explicit(&f->tag, memory_order_acquire);
+    for (;;) {
+        uint64_t c = t >> 2;  /* cycle + 1 */
+        unsigned int st = (unsigned int)(t & 3);
+        if (c > k + 1)
+            return 0;  /* 槽位只在所有主站过了第 k 周期后才复用，正常运行时不会出现 */
+        if (c == k + 1 && st == FRAME_ACCEPTED)
+            break;
+        if (c == k + 1 && st == FRAME_EXPIRED)
+            return 0;
+        uint64_t want = FRAME_TAG(k, c == k + 1 && st == FRAME_READY ? FRAME_ACCEPTED
+                                                                     : FRAME_EXPIRED);
+        if (atomic_compare_exchange_weak_explicit(&f->tag, &t, want, memory_order_acq_rel,
+                                                  memory_order_acquire))
+            t = want;
+    }
+    if (count)
+        memcpy(dst, f->pos + first, count * sizeof(*dst));
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&f->tag, memory_order_relaxed) == t;
+}
+
+static void default_cycle(master_member_t *m, uint64_t cycle, void *arg)
+{
+    (void)cycle;
+    member_impl_t *mi = arg;
+    if (m->safe_state) {
+        axis_table_write_control(m->axes, m->axes->cia402_mask, CIA402_CW_QUICK_STOP);
+        return;
+    }
+    if (!m->setpoints_fresh)
+        return;
+    axis_table_enabled_mask(m->axes, mi->mask);
+    axis_table_write_targets(m->axes, mi->mask, m->setpoints);
+}
+
+/* 把本主站轴的使能位 (mi->mask，本地下标) 写到全局位图的对应区间 */
+static void publish_enabled(master_group_t *g, member_impl_t *mi)
+{
+    unsigned int n = mi->pub.axes->n_axes;
+    for (unsigned int i = 0; i < n;) {
+        unsigned int gi = mi->pub.axis_first + i;
+        unsigned int sh = gi % 64u, lo = i % 64u, lw = i / 64u;
+        unsigned int span = 64u - sh < n - i ? 64u - sh : n - i;
+        uint64_t keep = span == 64u ? ~0ull : (1ull << span) - 1;
+        uint64_t v = mi->mask[lw] >> lo;
+        if (lo && lw + 1 < AXIS_MASK_WORDS(n))
+            v |= mi->mask[lw + 1] << (64u - lo);
+        v = (v & keep) << sh;
+        /* 同一个字里其他主站的位不受影响 */
+        atomic_fetch_and_explicit(&g->enabled[gi / 64u], ~((keep << sh) & ~v),
+                                  memory_order_relaxed);
+        atomic_fetch_or_explicit(&g->enabled[gi / 64u], v, memory_order_relaxed);
+        i += span;
+    }
+}
+
+/* 第 0 个主站线程：所有主站已应用当前版本时才同步，切换后在下一周期统一生效 */
+static void reload_sync(master_group_t *g, uint64_t k)
+{
+    uint32_t gen = atomic_load_explicit(&g->live_gen, memory_order_relaxed);
+    for (unsigned int i = 0; i < g->n_members; i++) {
+        if (atomic_load_explicit(&g->members[i].applied_gen, memory_order_acquire) != gen)
+            return;
+    }
+    for (unsigned int w = 0; w < AXIS_MASK_WORDS(g->cfg->n_axes); w++)
+        g->enabled_snap[w] = atomic_load_explicit(&g->enabled[w], memory_order_relaxed);
+    const axis_config_table_t *tbl = config_reload_sync(g->reload, g->enabled_snap);
+    if (tbl == g->live)
+        return;
+    g->live = tbl;
+    g->live_cycle = k + 1;
+    atomic_store_explicit(&g->live_gen, gen + 1, memory_order_release);
+}
+
+/* 新表的比例因子与模拟量参数应用到本主站 (拓扑不变，按本主站区间截取) */
+static void reload_apply(master_group_t *g, member_impl_t *mi, uint64_t k)
+{
+    uint32_t gen = atomic_load_explicit(&g->live_gen, memory_order_acquire);
+    if (gen == atomic_load_explicit(&mi->applied_gen, memory_order_relaxed) ||
+        k < g->live_cycle)
+        return;
+    const axis_config_table_t *tbl = g->live;
+    axis_config_table_t slice = {
+        .axes = tbl->axes + mi->pub.axis_first,
+        .n_axes = mi->view.n_axes,
+    };
+    axis_table_apply_scales(mi->pub.axes, &slice);
+    analog_pipeline_apply(mi->pub.analog, tbl->analog + (mi->view.analog - g->cfg->analog),
+                          mi->view.n_analog);
+    atomic_store_explicit(&mi->applied_gen, gen, memory_order_release);
+}
+
+/* 本周期的间隔、执行时间与调度统计随轴状态一起发布 */
+static void publish_telemetry(member_impl_t *mi, const cycle_tick_t *tick, uint64_t end_ns)
+{
+    telemetry_stats_t *st = &mi->tlm_stats;
+    st->period_ns = st->timestamp_ns ? (uint32_t)(tick->wake_ns - st->timestamp_ns) : 0;
+    st->cycle = tick->cycle;
+    st->timestamp_ns = tick->wake_ns;
+    st->exec_ns = (uint32_t)(end_ns - tick->wake_ns);
+    if (st->period_ns > st->period_max_ns)
+        st->period_max_ns = st->period_ns;
+    if (st->exec_ns > st->exec_max_ns)
+        st->exec_max_ns = st->exec_ns;
+
+    cycle_sched_stats_t ss;
+    cycle_sched_get_stats(mi->sched, &ss);
+    st->deadline_misses = ss.deadline_misses;
+    st->skipped = ss.skipped;
+    st->caught_up = ss.caught_up;
+    st->max_lateness_ns = ss.max_lateness_ns;
+    st->safe_state = (uint32_t)ss.safe_state;
+    telemetry_shm_publish(mi->tlm, mi->pub.domain_pd, st);
+}
+
+static void *member_thread(void *arg)
+{
+    member_impl_t *mi = arg;
+    master_group_t *g = mi->group;
+    master_member_t *m = &mi->pub;
+    unsigned int n = m->axes->n_axes;
+    int cur = 0;
+    cycle_tick_t tick;
+
+    while (atomic_load_explicit(&g->running, memory_order_relaxed)) {
+        /* 所有主站的调度器共用 epoch，时隙 k 的起点相同；超时按配置的策略恢复 */
+        cycle_sched_wait(mi->sched, &tick);
+        uint64_t k = tick.cycle;
+        m->safe_state = tick.safe_state;
+
+        /* 时隙起点交给主站作为 application time；未配置 DC，对齐只在主机侧 */
+        ecrt_master_application_time(m->master, tick.slot_ns);
+        ecrt_master_receive(m->master);
+        ecrt_domain_process(m->domain);
+        if (g->reload) {
+            axis_table_enabled_mask(m->axes, mi->mask);
+            publish_enabled(g, mi);
+            if (mi == &g->members[0])
+                reload_sync(g, k);
+            reload_apply(g, mi, k);
+        }
+        health_monitor_cycle(mi->health, k);
+        analog_pipeline_cycle(m->analog, k);
+        di_edge_cycle(m->di, k, tick.slot_ns);
+        touch_probe_cycle(m->probe, k, tick.slot_ns);
+        modbus_gw_cycle(m->modbus, k);
+
+        if (take_frame(g, k, mi->buf[cur ^ 1], m->axis_first, n)) {
+            cur ^= 1;
+            m->setpoints = mi->buf[cur];
+            m->setpoints_fresh = 1;
+        } else {
+            m->setpoints_fresh = 0;
+            atomic_fetch_add_explicit(&mi->stale_frames, 1, memory_order_relaxed);
+        }
+        atomic_store_explicit(&mi->taken, k + 1, memory_order_release);
+
+        if (g->fn)
+            g->fn(m, k, g->arg);
+        else
+            default_cycle(m, k, mi);
+
+        ecrt_domain_queue(m->domain);
+        ecrt_master_send(m->master);
+        cycle_sched_done(mi->sched);
+
+        uint64_t t1 = now_ns();
+        if (!tick.catchup)
+            atomic_max_u32(&mi->wake_latency_max_ns, (uint32_t)(tick.wake_ns - tick.slot_ns));
+        atomic_max_u32(&mi->exec_max_ns, (uint32_t)(t1 - tick.wake_ns));
+        if (mi->tlm)
+            publish_telemetry(mi, &tick, t1);
+    }
+    return NULL;
+}
+
+/* 在排好序的全局配置中截取某个主站的从站/轴区间 */
+static void make_view(const axis_config_table_t *cfg, int master, axis_config_table_t *view,
+                      unsigned int *axis_first)
+{
+    unsigned int s0 = 0, a0 = 0;
+    while (s0 < cfg->n_slaves && cfg->slaves[s0].master != master)
+        s0++;
+    unsigned int s1 = s0;
+    while (s1 < cfg->n_slaves && cfg->slaves[s1].master == master)
+        s1++;
+    while (a0 < cfg->n_axes && cfg->axes[a0].master != master)
+        a0++;
+    unsigned int a1 = a0;
+    while (a1 < cfg->n_axes && cfg->axes[a1].master == master)
+        a1++;
+    unsigned int c0 = 0;
+    while (c0 < cfg->n_analog && cfg->analog[c0].master != master)
+        c0++;
+    unsigned int c1 = c0;
+    while (c1 < cfg->n_analog && cfg->analog[c1].master == master)
+        c1++;
+    unsigned int d0 = 0;
+    while (d0 < cfg->n_di && cfg->di[d0].master != master)
+        d0++;
+    unsigned int d1 = d0;
+    while (d1 < cfg->n_di && cfg->di[d1].master == master)
+        d1++;
+
+    memcpy(view->eni_path, cfg->eni_path, sizeof(view->eni_path));
+    view->cycle_us = cfg->cycle_us;
+    view->n_masters = 1;
+    view->slaves = cfg->slaves + s0;
+    view->n_slaves = s1 - s0;
+    view->axes = cfg->axes + a0;
+    view->n_axes = a1 - a0;
+    view->analog = cfg->analog + c0;
+    view->n_analog = c1 - c0;
+    view->di = cfg->di + d0;
+    view->n_di = d1 - d0;
+    *axis_first = a0;
+}
+
+static const master_bus_t *find_bus(const master_bus_t *buses, unsigned int n, int master)
+{
+    for (unsigned int i = 0; i < n; i++) {
+        if (buses[i].master == master)
+            return &buses[i];
+    }
+    return NULL;
+}
+
+/* 本主站配置了 modbus_gateway 的从站上创建网关 (每个主站至多一个) */
+static int create_modbus(const axis_config_table_t *view, const master_bus_t *bus,
+                         modbus_gw_t **out, char *why, size_t why_len)
+{
+    for (unsigned int i = 0; i < view->n_slaves; i++) {
+        if (!view->slaves[i].modbus_gateway)
+            continue;
+        for (unsigned int s = 0; s < bus->n_slaves; s++) {
+            if (bus->slaves[s].position == (uint16_t)view->slaves[i].id)
+                return modbus_gw_create(&bus->slaves[s], view->cycle_us, 0, out, why, why_len);
+        }
+        snprintf(why, why_len, "modbus gateway slave %d not in bus layout", view->slaves[i].id);
+        return -EINVAL;
+    }
+    return 0;
+}
+
+static int setup_master(member_impl_t *mi, const master_bus_t *bus, char *err, size_t err_len)
+{
+    master_member_t *m = &mi->pub;
+    m->master = ecrt_request_master((unsigned int)m->index);
+    if (!m->master)
+        return group_fail(err, err_len, -ENODEV, "failed to request master %d", m->index);
+    m->domain = ecrt_master_create_domain(m->master);
+    if (!m->domain)
+        return group_fail(err, err_len, -ENOMEM, "master %d: failed to create domain",
+                          m->index);
+
+    mi->sc = calloc(bus->n_slaves ? bus->n_slaves : 1, sizeof(*mi->sc));
+    mi->sc_pos = calloc(bus->n_slaves ? bus->n_slaves : 1, sizeof(*mi->sc_pos));
+    if (!mi->sc || !mi->sc_pos)
+        return -ENOMEM;
+    for (unsigned int s = 0; s < bus->n_slaves; s++) {
+        const axis_slave_desc_t *sd = &bus->slaves[s];
+        ec_slave_config_t *sc = ecrt_master_slave_config(m->master, sd->alias, sd->position,
+                                                         sd->vendor_id, sd->product_code);
+        if (!sc)
+            return group_fail(err, err_len, -EIO, "master %d: failed to configure slave %u",
+                              m->index, sd->position);
+        if (ecrt_slave_config_pdos(sc, EC_END, sd->syncs))
+            return group_fail(err, err_len, -EIO, "master %d: failed to configure PDOs of slave %u",
+                              m->index, sd->position);
+        mi->sc[s] = sc;
+        mi->sc_pos[s] = sd->position;
+    }
+    if (ecrt_domain_reg_pdo_entry_list(m->domain, axis_table_regs(m->axes)) ||
+        ecrt_domain_reg_pdo_entry_list(m->domain, analog_pipeline_regs(m->analog)) ||
+        (m->di && ecrt_domain_reg_pdo_entry_list(m->domain, di_edge_regs(m->di))) ||
+        (m->modbus && ecrt_domain_reg_pdo_entry_list(m->domain, modbus_gw_regs(m->modbus))))
+        return group_fail(err, err_len, -EIO, "master %d: PDO entry registration failed",
+                          m->index);
+    return 0;
+}
+
+int master_group_create(const axis_config_table_t *cfg, const master_bus_t *buses,
+                        unsigned int n_buses, master_cycle_fn fn, void *arg,
+                        master_group_t **out, char *err, size_t err_len)
+{
+    if (!cfg || !out || (n_buses && !buses))
+        return -EINVAL;
+
+    master_group_t *g = calloc(1, sizeof(*g));
+    if (!g)
+        return -ENOMEM;
+    g->cfg = cfg;
+    g->fn = fn;
+    g->arg = arg;
+    g->period_ns = (uint64_t)cfg->cycle_us * 1000ull;
+    atomic_init(&g->running, 0);
+
+    int r = diag_ring_create(MASTER_GROUP_DIAG_CAPACITY, &g->diag);
+    for (unsigned int i = 0; i < MASTER_GROUP_FRAMES && !r; i++) {
+        atomic_init(&g->frames[i].tag, 0);
+        g->frames[i].pos = calloc(cfg->n_axes ? cfg->n_axes : 1, sizeof(double));
+        if (!g->frames[i].pos)
+            r = -ENOMEM;
+    }
+
+    /* 先完成全部主站的离线校验，再请求主站 */
+    for (unsigned int i = 0; i < cfg->n_masters && !r; i++) {
+        member_impl_t *mi = &g->members[g->n_members];
+        master_member_t *m = &mi->pub;
+        const master_bus_t *bus = find_bus(buses, n_buses, cfg->masters[i].index);
+        if (!bus) {
+            r = group_fail(err, err_len, -EINVAL, "no bus layout for master %d",
+                           cfg->masters[i].index);
+            break;
+        }
+        mi->group = g;
+        m->index = cfg->masters[i].index;
+        m->cpu = cfg->masters[i].cpu;
+        make_view(cfg, m->index, &mi->view, &m->axis_first);
+        mi->view.masters[0] = cfg->masters[i];
+        g->n_members++;
+
+        char why[160];
+        r = axis_table_create(&mi->view, bus->slaves, bus->n_slaves, &m->axes, why, sizeof(why));
+        if (!r)
+            r = analog_pipeline_create(mi->view.analog, mi->view.n_analog, bus->slaves,
+                                       bus->n_slaves, g->diag, (uint16_t)m->index, &m->analog,
+                                       why, sizeof(why));
+        if (!r && mi->view.n_di)
+            r = di_edge_create(mi->view.di, mi->view.n_di, bus->slaves, bus->n_slaves,
+                               cfg->cycle_us, &m->di, why, sizeof(why));
+        if (!r)
+            r = create_modbus(&mi->view, bus, &m->modbus, why, sizeof(why));
+        if (r) {
+            r = group_fail(err, err_len, r, "master %d: %s", m->index, why);
+            break;
+        }
+        unsigned int n = mi->view.n_axes ? mi->view.n_axes : 1;
+        mi->buf[0] = calloc(n, sizeof(double));
+        mi->buf[1] = calloc(n, sizeof(double));
+        mi->mask = calloc(AXIS_MASK_WORDS(n), sizeof(uint64_t));
+        if (!mi->buf[0] || !mi->buf[1] || !mi->mask)
+            r = -ENOMEM;
+        touch_probe_config_t pc = {.continuous = 1};
+        if (!r)
+            r = touch_probe_create(m->axes, &pc, &m->probe);
+        m->setpoints = mi->buf[0];
+    }
+
+    for (unsigned int i = 0; i < g->n_members && !r; i++) {
+        member_impl_t *mi = &g->members[i];
+        r = setup_master(mi, find_bus(buses, n_buses, mi->pub.index), err, err_len);
+    }
+    for (unsigned int i = 0; i < g->n_members && !r; i++) {
+        master_member_t *m = &g->members[i].pub;
+        if (ecrt_master_activate(m->master)) {
+            r = group_fail(err, err_len, -EIO, "master %d: activation failed", m->index);
+            break;
+        }
+        m->domain_pd = ecrt_domain_data(m->domain);
+        if (!m->domain_pd) {
+            r = group_fail(err, err_len, -EIO, "master %d: no domain data", m->index);
+            break;
+        }
+        axis_table_bind(m->axes, m->domain_pd);
+        analog_pipeline_bind(m->analog, m->domain_pd);
+        if (m->di)
+            di_edge_bind(m->di, m->domain_pd);
+        if (m->modbus)
+            modbus_gw_bind(m->modbus, m->domain_pd);
+
+        member_impl_t *mi = &g->members[i];
+        health_monitor_config_t hc = {
+            .master = m->master,
+            .domains = &m->domain,
+            .n_domains = 1,
+            .slaves = mi->sc,
+            .slave_pos = mi->sc_pos,
+            .n_slaves = find_bus(buses, n_buses, m->index)->n_slaves,
+            .diag = g->diag,
+            .source = (uint16_t)m->index,
+        };
+        r = health_monitor_create(&hc, &mi->health);
+        if (r)
+            break;
+    }
+
+    if (r) {
+        if (r == -ENOMEM && err && err_len)
+            snprintf(err, err_len, "out of memory");
+        master_group_destroy(g);
+        return r;
+    }
+    *out = g;
+    return 0;
+}
+
+int master_group_start(master_group_t *g)
+{
+    if (!g || atomic_load(&g->running))
+        return -EINVAL;
+
+    uint64_t lead = g->period_ns * 2 > START_LEAD_NS ? g->period_ns * 2 : START_LEAD_NS;
+    g->epoch_ns = now_ns() + lead;
+
+    for (unsigned int i = 0; i < g->n_members; i++) {
+        member_impl_t *mi = &g->members[i];
+        cycle_sched_config_t sc = {
+            .period_ns = (uint32_t)g->period_ns,
+            .policy = g->cfg->overrun_policy,
+            .max_catchup = g->cfg->max_catchup,
+            .safe_after = g->cfg->safe_after_misses,
+            .diag = g->diag,
+            .source = (uint16_t)mi->pub.index,
+        };
+        cycle_sched_destroy(mi->sched);
+        mi->sched = NULL;
+        int r = cycle_sched_create(&sc, g->epoch_ns, &mi->sched);
+        if (r)
+            return r;
+    }
+    atomic_store(&g->running, 1);
+
+    for (unsigned int i = 0; i < g->n_members; i++) {
+        member_impl_t *mi = &g->members[i];
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        if (mi->pub.cpu >= 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(mi->pub.cpu, &set);
+            pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+        }
+        struct sched_param sp = {.sched_priority = MASTER_GROUP_RT_PRIORITY};
+        pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+        pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+        pthread_attr_setschedparam(&attr, &sp);
+        int r = pthread_create(&mi->thread, &attr, member_thread, mi);
+        if (r == EPERM) {
+            /* 没有实时调度权限：沿用默认调度，仍保留绑核 */
+            pthread_attr_setinheritsched(&attr, PTHREAD_INHERIT_SCHED);
+            r = pthread_create(&mi->thread, &attr, member_thread, mi);
+        }
+        pthread_attr_destroy(&attr);
+        if (r) {
+            master_group_stop(g);
+            return -r;
+        }
+        mi->started = 1;
+    }
+    return 0;
+}
+
+/* 遥测中每个 CiA402 轴发布的对象 (索引加轴的 offset) */
+static const struct {
+    uint16_t         index;
+    telemetry_type_t type;
+    const char      *suffix;
+} telemetry_objs[] = {
+    {0x6041, TELEMETRY_U16, "status_word"},
+    {0x6064, TELEMETRY_S32, "actual_pos"},
+};
+#define TELEMETRY_OBJS (sizeof(telemetry_objs) / sizeof(telemetry_objs[0]))
+
+/* 轴表注册表中 (从站, 对象) 的一项，未注册返回 NULL */
+static const ec_pdo_entry_reg_t *find_reg(const axis_table_t *at, uint16_t position,
+                                          uint16_t index)
+{
+    for (unsigned int r = 0; r < at->n_regs; r++) {
+        if (at->regs[r].position == position && at->regs[r].index == index)
+            return &at->regs[r];
+    }
+    return NULL;
+}
+
+static int create_telemetry(master_group_t *g, member_impl_t *mi, const char *name,
+                            unsigned int decimation)
+{
+    const axis_table_t *at = mi->pub.axes;
+    unsigned int n = mi->view.n_axes;
+    telemetry_source_t *src = calloc(TELEMETRY_OBJS * n + 1, sizeof(*src));
+    char (*names)[TELEMETRY_FIELD_NAME_LEN] = calloc(TELEMETRY_OBJS * n + 1, sizeof(*names));
+    if (!src || !names) {
+        free(src);
+        free(names);
+        return -ENOMEM;
+    }
+
+    unsigned int k = 0;
+    for (unsigned int i = 0; i < n; i++) {
+        if (!axis_mask_test(at->cia402_mask, i))
+            continue;
+        const axis_config_t *ax = &mi->view.axes[i];
+        for (size_t o = 0; o < TELEMETRY_OBJS; o++) {
+            uint16_t index = (uint16_t)(telemetry_objs[o].index + ax->offset);
+            const ec_pdo_entry_reg_t *reg = find_reg(at, at->slave_pos[i], index);
+            if (!reg)
+                continue;
+            snprintf(names[k], sizeof(names[k]), "axis%d.%s", ax->axis_id,
+                     telemetry_objs[o].suffix);
+            src[k] = (telemetry_source_t){
+                .name = names[k],
+                .slave = at->slave_pos[i],
+                .index = index,
+                .subindex = reg->subindex,
+                .type = telemetry_objs[o].type,
+                .pd_offset = reg->offset,
+            };
+            k++;
+        }
+    }
+
+    char seg[64];
+    snprintf(seg, sizeof(seg), "%s.%d", name, mi->pub.index);
+    memset(&mi->tlm_stats, 0, sizeof(mi->tlm_stats));
+    int r = telemetry_shm_create(seg, src, k, decimation, g->cfg->cycle_us, &mi->tlm);
+    free(src);
+    free(names);
+    return r;
+}
+
+int master_group_set_telemetry(master_group_t *g, const char *name, unsigned int decimation)
+{
+    if (!g || !name)
+        return -EINVAL;
+    if (atomic_load(&g->running))
+        return -EBUSY;
+    int r = 0;
+    for (unsigned int i = 0; i < g->n_members; i++) {
+        member_impl_t *mi = &g->members[i];
+        telemetry_shm_destroy(mi->tlm);
+        mi->tlm = NULL;
+        if (!r)
+            r = create_telemetry(g, mi, name, decimation);
+    }
+    if (r) {
+        for (unsigned int i = 0; i < g->n_members; i++) {
+            telemetry_shm_destroy(g->members[i].tlm);
+            g->members[i].tlm = NULL;
+        }
+    }
+    return r;
+}
+
+int master_group_set_reload(master_group_t *g, config_reload_t *cr)
+{
+    if (!g || !cr)
+        return -EINVAL;
+    if (atomic_load(&g->running))
+        return -EBUSY;
+    unsigned int words = AXIS_MASK_WORDS(g->cfg->n_axes ? g->cfg->n_axes : 1);
+    if (!g->enabled) {
+        g->enabled = calloc(words, sizeof(*g->enabled));
+        g->enabled_snap = calloc(words, sizeof(*g->enabled_snap));
+        if (!g->enabled || !g->enabled_snap)
+            return -ENOMEM;
+        for (unsigned int w = 0; w < words; w++)
+            atomic_init(&g->enabled[w], 0);
+    }
+    g->reload = cr;
+    g->live = NULL;
+    atomic_store(&g->live_gen, 0);
+    for (unsigned int i = 0; i < g->n_members; i++)
+        atomic_store(&g->members[i].applied_gen, 0);
+    return 0;
+}
+
+uint64_t master_group_cycle(const master_group_t *g)
+{
+    uint64_t now = now_ns();
+    if (!g->epoch_ns || now < g->epoch_ns)
+        return 0;
+    return (now - g->epoch_ns) / g->period_ns;
+}
+
+int master_group_publish(master_group_t *g, uint64_t cycle, const double *pos)
+{
+    uint64_t now = master_group_cycle(g);
+    if (atomic_load_explicit(&g->running, memory_order_relaxed) && cycle <= now)
+        return -ETIME;
+    if (cycle + 2 > now + MASTER_GROUP_FRAMES)
+        return -EAGAIN;
+
+    setpoint_frame_t *f = &g->frames[cycle % MASTER_GROUP_FRAMES];
+    uint64_t t = atomic_load_explicit(&f->tag, memory_order_acquire);
+    /* 槽中的旧帧还有主站没取 (该主站落后)：复用会让它与其他主站得出不同结论 */
+    for (unsigned int i = 0; t && (t >> 2) < cycle + 1 && i < g->n_members; i++) {
+        if (atomic_load_explicit(&g->members[i].taken, memory_order_acquire) < (t >> 2))
+            return -EAGAIN;
+    }
+    do {
+        if ((t >> 2) >= cycle + 1)
+            return (t >> 2) == cycle + 1 && (t & 3) != FRAME_EXPIRED ? -EEXIST : -ETIME;
+    } while (!atomic_compare_exchange_weak_explicit(&f->tag, &t, FRAME_TAG(cycle, FRAME_WRITING),
+                                                    memory_order_acq_rel,
+                                                    memory_order_acquire));
+
+    memcpy(f->pos, pos, g->cfg->n_axes * sizeof(*pos));
+
+    uint64_t w = FRAME_TAG(cycle, FRAME_WRITING);
+    if (!atomic_compare_exchange_strong_explicit(&f->tag, &w, FRAME_TAG(cycle, FRAME_READY),
+                                                 memory_order_release, memory_order_relaxed))
+        return -ETIME;  /* 写入期间该周期已开始，帧已被判定过期 */
+    return 0;
+}
+
+unsigned int master_group_count(const master_group_t *g)
+{
+    return g->n_members;
+}
+
+master_member_t *master_group_member(master_group_t *g, unsigned int i)
+{
+    return i < g->n_members ? &g->members[i].pub : NULL;
+}
+
+int master_group_get_stats(const master_group_t *g, unsigned int i, master_stats_t *st)
+{
+    if (!g || i >= g->n_members || !st)
+        return -EINVAL;
+    member_impl_t *mi = (member_impl_t *)&g->members[i];
+    if (mi->sched)
+        cycle_sched_get_stats(mi->sched, &st->sched);
+    else
+        memset(&st->sched, 0, sizeof(st->sched));
+    st->stale_frames = atomic_load_explicit(&mi->stale_frames, memory_order_relaxed);
+    st->wake_latency_max_ns = atomic_load_explicit(&mi->wake_latency_max_ns, memory_order_relaxed);
+    st->exec_max_ns = atomic_load_explicit(&mi->exec_max_ns, memory_order_relaxed);
+    return 0;
+}
+
+void master_group_clear_safe(master_group_t *g)
+{
+    for (unsigned int i = 0; i < g->n_members; i++) {
+        if (g->members[i].sched)
+            cycle_sched_clear_safe(g->members[i].sched);
+    }
+}
+
+diag_ring_t *master_group_diag(master_group_t *g)
+{
+    return g->diag;
+}
+
+const health_monitor_t *master_group_health(const master_group_t *g, unsigned int i)
+{
+    return i < g->n_members ? g->members[i].health : NULL;
+}
+
+void master_group_stop(master_group_t *g)
+{
+    if (!g)
+        return;
+    atomic_store(&g->running, 0);
+    for (unsigned int i = 0; i < g->n_members; i++) {
+        member_impl_t *mi = &g->members[i];
+        if (mi->started) {
+            pthread_join(mi->thread, NULL);
+            mi->started = 0;
+        }
+    }
+}
+
+void master_group_destroy(master_group_t *g)
+{
+    if (!g)
+        return;
+    master_group_stop(g);
+    for (unsigned int i = 0; i < g->n_members; i++) {
+        member_impl_t *mi = &g->members[i];
+        if (mi->pub.master)
+            ecrt_release_master(mi->pub.master);
+        axis_table_destroy(mi->pub.axes);
+        analog_pipeline_destroy(mi->pub.analog);
+        di_edge_destroy(mi->pub.di);
+        touch_probe_destroy(mi->pub.probe);
+        modbus_gw_destroy(mi->pub.modbus);
+        cycle_sched_destroy(mi->sched);
+        health_monitor_destroy(mi->health);
+        telemetry_shm_destroy(mi->tlm);
+        free(mi->sc);
+        free(mi->sc_pos);
+        free(mi->buf[0]);
+        free(mi->buf[1]);
+        free(mi->mask);
+    }
+    for (unsigned int i = 0; i < MASTER_GROUP_FRAMES; i++)
+        free(g->frames[i].pos);
+    free(g->enabled);
+    free(g->enabled_snap);
+    diag_ring_destroy(g->diag);
+    free(g);
+}
@@ -0,0 +1,546 @@
+/*
+ * modbus_gateway.c
+ *
+ * Modbus 网关实现，接口与 PDO 协议见 modbus_gateway.h。
+ *
+ * 事务槽 slots[] 在网关线程与周期任务之间传递：网关线程填写命令后把槽下标推入 submit 环，
+ * 周期任务发出并在完成时写入结果、把下标推入 complete 环，网关线程分发结果后回收槽。
+ * 槽的所有权随下标在环中转移，环的 release/acquire 保证槽内容可见。
+ * pending 队列 (尚未全部编入事务的请求) 由 lock 保护，只有应用线程与网关线程访问。
+ */
+
+#define _GNU_SOURCE
+
+#include "modbus_gateway.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "spsc_ring.h"
+
+/* RxPDO / TxPDO 中协议用到的对象，顺序与 ESI 中的对象号一致 (0x7001 DigitalOutputs 不使用) */
+enum {
+    OUT_DO_COMMAND = 0,     /* 0x7002 ModbusDoCommand */
+    OUT_SLAVE_ID,           /* 0x7003 ModbusSlaveID */
+    OUT_FUNCTION,           /* 0x7004 ModbusFunction */
+    OUT_ADDR,               /* 0x7005 ModbusRegisterAddr */
+    OUT_COUNT,              /* 0x7006 ModbusRegisterCount */
+    OUT_DATA0,              /* 0x7007 ~ 0x7011 ModbusRegisterData0 ~ 10 */
+    IN_STATE = OUT_DATA0 + MODBUS_GW_WRITE_WINDOW,  /* 0x6006 ModbusState */
+    IN_ERROR,               /* 0x6007 ModbusErrorCode */
+    IN_COUNT,               /* 0x6008 ModbusRegistersCount */
+    IN_DATA0,               /* 0x6009 ~ 0x6014 ModbusRegisterData0 ~ 11 */
+    PDO_COUNT = IN_DATA0 + MODBUS_GW_READ_WINDOW,
+};
+
+#define OUT_BASE 0x7002
+#define IN_BASE  0x6006
+
+typedef struct {
+    modbus_gw_req_t *req;
+    uint16_t         req_off;   /* 在请求中的寄存器偏移 */
+    uint16_t         tx_off;    /* 在事务中的寄存器偏移 */
+    uint16_t         count;
+} tx_part_t;
+
+typedef struct {
+    /* 网关线程填写 */
+    uint8_t   unit;
+    uint8_t   function;
+    uint16_t  addr;
+    uint16_t  count;
+    uint16_t  data[MODBUS_GW_READ_WINDOW];   /* 写数据；完成后为读结果 */
+    unsigned int n_parts;
+    tx_part_t parts[MODBUS_GW_READ_WINDOW];
+
+    /* 周期任务填写 */
+    int       status;
+    uint16_t  n_result;
+} tx_slot_t;
+
+struct modbus_gw {
+    /* PDO */
+    ec_pdo_entry_reg_t regs[PDO_COUNT + 1];
+    unsigned int       offsets[PDO_COUNT];
+    uint8_t           *pdo[PDO_COUNT];
+    int                bound;
+
+    /* 周期任务独占 */
+    int                busy;        /* 已置 DoCommand = 1，等待 DONE / ERROR */
+    uint32_t           busy_slot;
+    uint64_t           issued;      /* 发出时的周期号 */
+    uint64_t           timeout_cycles;
+
+    /* 槽与环 */
+    tx_slot_t          slots[MODBUS_GW_SLOTS];
+    spsc_ring_t       *submit;
+    spsc_ring_t       *complete;
+    uint32_t           free_slots[MODBUS_GW_SLOTS];   /* 网关线程独占 */
+    unsigned int       n_free;
+
+    /* pending 队列 */
+    pthread_mutex_t    lock;
+    pthread_cond_t     cond;
+    modbus_gw_req_t   *head;
+    modbus_gw_req_t   *tail;
+    int                running;
+    pthread_t          thread;
+    int                started;
+    uint32_t           poll_ns;
+
+    _Atomic uint64_t   requests;
+    _Atomic uint64_t   transactions;
+    _Atomic uint64_t   registers;
+    _Atomic uint64_t   merged;
+    _Atomic uint64_t   errors;
+    _Atomic uint64_t   timeouts;
+};
+
+/* modbus_gw_transfer() 的同步等待 */
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    int             done;
+} sync_wait_t;
+
+#define INC(x, n) atomic_fetch_add_explicit(&(x), (n), memory_order_relaxed)
+#define LOAD(x)   atomic_load_explicit(&(x), memory_order_relaxed)
+
+static int gw_fail(char *err, size_t err_len, int ret, const char *fmt, ...)
+{
+    if (err && err_len) {
+        va_list ap;
+        va_start(ap, fmt);
+        vsnprintf(err, err_len, fmt, ap);
+        va_end(ap);
+    }
+    return ret;
+}
+
+/* 在 PDO 映射中查找对象；找到返回 0，并给出子索引、位宽与方向 */
+static int pdo_lookup(const ec_sync_info_t *syncs, uint16_t index, uint8_t *subindex,
+                      uint8_t *bits, ec_direction_t *dir)
+{
+    for (const ec_sync_info_t *sm = syncs; sm && sm->index != 0xff; sm++) {
+        for (unsigned int p = 0; p < sm->n_pdos; p++) {
+            const ec_pdo_info_t *pdo = &sm->pdos[p];
+            for (unsigned int e = 0; e < pdo->n_entries; e++) {
+                if (pdo->entries[e].index == index) {
+                    *subindex = pdo->entries[e].subindex;
+                    *bits = pdo->entries[e].bit_length;
+                    *dir = sm->dir;
+                    return 0;
+                }
+            }
+        }
+    }
+    return -1;
+}
+
+/* --- 网关线程 --- */
+
+/* 请求的一段完成 (或取消)；全部完成时回调 */
+static void finish_part(modbus_gw_t *gw, modbus_gw_req_t *req, uint16_t count, int status)
+{
+    if (status && !req->status)
+        req->status = status;
+    req->remaining = (uint16_t)(req->remaining - count);
+    if (!req->remaining) {
+        INC(gw->requests, 1);
+        if (req->done)
+            req->done(req, req->arg);
+    }
+}
+
+static void complete_slot(modbus_gw_t *gw, uint32_t idx)
+{
+    tx_slot_t *s = &gw->slots[idx];
+    int status = s->status;
+    int is_read = s->function == MODBUS_FC_READ_HOLDING || s->function == MODBUS_FC_READ_INPUT;
+    if (!status && is_read && s->n_result < s->count)
+        status = -EIO;  /* 固件返回的寄存器数不足 */
+
+    INC(gw->transactions, 1);
+    if (status > 0)
+        INC(gw->errors, 1);
+    else if (!status)
+        INC(gw->registers, s->count);
+
+    for (unsigned int p = 0; p < s->n_parts; p++) {
+        tx_part_t *part = &s->parts[p];
+        if (!status && is_read)
+            memcpy(part->req->regs + part->req_off, s->data + part->tx_off,
+                   part->count * sizeof(uint16_t));
+        finish_part(gw, part->req, part->count, status);
+    }
+    gw->free_slots[gw->n_free++] = idx;
+}
+
+/*
+ * 从 pending 队首编一个事务：同站号、同功能码、地址连续的请求合并，
+ * 超过窗口 (读 12、写 11 个寄存器) 的请求拆成多个事务。调用时持有 lock。
+ */
+static void build_slot(modbus_gw_t *gw, tx_slot_t *s)
+{
+    modbus_gw_req_t *r = gw->head;
+    s->unit = r->unit;
+    s->function = r->function;
+    s->addr = (uint16_t)(r->addr + r->scheduled);
+    s->count = 0;
+    s->n_parts = 0;
+    s->status = 0;
+    s->n_result = 0;
+
+    int is_write = r->function == MODBUS_FC_WRITE_SINGLE || r->function == MODBUS_FC_WRITE_MULTIPLE;
+    uint16_t window = is_write ? MODBUS_GW_WRITE_WINDOW : MODBUS_GW_READ_WINDOW;
+    while ((r = gw->head)) {
+        if (s->n_parts) {
+            if (r->unit != s->unit || r->function != s->function ||
+                r->function == MODBUS_FC_WRITE_SINGLE ||
+                (uint32_t)r->addr + r->scheduled != (uint32_t)s->addr + s->count)
+                break;
+            INC(gw->merged, 1);
+        }
+        uint16_t take = (uint16_t)(r->count - r->scheduled);
+        if (take > window - s->count)
+            take = (uint16_t)(window - s->count);
+
+        tx_part_t *part = &s->parts[s->n_parts++];
+        part->req = r;
+        part->req_off = r->scheduled;
+        part->tx_off = s->count;
+        part->count = take;
+        if (is_write)
+            memcpy(s->data + s->count, r->regs + r->scheduled, take * sizeof(uint16_t));
+        r->scheduled = (uint16_t)(r->scheduled + take);
+        s->count = (uint16_t)(s->count + take);
+
+        if (r->scheduled < r->count)
+            break;  /* 窗口已满，剩余部分留给下一个事务 */
+        gw->head = r->next;
+        if (!gw->head)
+            gw->tail = NULL;
+        if (s->count == window)
+            break;
+    }
+}
+
+static void *gw_thread(void *arg)
+{
+    modbus_gw_t *gw = arg;
+    pthread_mutex_lock(&gw->lock);
+    while (gw->running) {
+        pthread_mutex_unlock(&gw->lock);
+        uint32_t idx;
+        while (spsc_ring_pop(gw->complete, &idx))
+            complete_slot(gw, idx);
+        pthread_mutex_lock(&gw->lock);
+
+        while (gw->head && gw->n_free) {
+            uint32_t slot = gw->free_slots[--gw->n_free];
+            build_slot(gw, &gw->slots[slot]);
+            spsc_ring_push(gw->submit, &slot);  /* 环容量 >= 槽数，不会失败 */
+        }
+
+        /* 新请求到达时立即被唤醒，否则按周期轮询完成环 */
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += gw->poll_ns;
+        if (ts.tv_nsec >= 1000000000L) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+        if (gw->running && (!gw->head || !gw->n_free))
+            pthread_cond_timedwait(&gw->cond, &gw->lock, &ts);
+    }
+    pthread_mutex_unlock(&gw->lock);
+    return NULL;
+}
+
+/* --- 周期任务 --- */
+
+static void rt_finish(modbus_gw_t *gw, int status, uint16_t n_result)
+{
+    tx_slot_t *s = &gw->slots[gw->busy_slot];
+    s->status = status;
+    s->n_result = n_result;
+    spsc_ring_push(gw->complete, &gw->busy_slot);
+    gw->busy = 0;
+    EC_WRITE_U16(gw->pdo[OUT_DO_COMMAND], 0);  /* 结束握手，固件回到 IDLE */
+}
+
+void modbus_gw_cycle(modbus_gw_t *gw, uint64_t cycle)
+{
+    if (!gw || !gw->bound)
+        return;
+
+    uint16_t state = EC_READ_U16(gw->pdo[IN_STATE]);
+
+    if (gw->busy) {
+        if (state == MODBUS_GW_STATE_DONE || state == MODBUS_GW_STATE_ERROR) {
+            tx_slot_t *s = &gw->slots[gw->busy_slot];
+            int err = EC_READ_U16(gw->pdo[IN_ERROR]);
+            if (!err && state == MODBUS_GW_STATE_ERROR)
+                err = -EIO;
+            uint16_t n = EC_READ_U16(gw->pdo[IN_COUNT]);
+            if (n > MODBUS_GW_READ_WINDOW)
+                n = MODBUS_GW_READ_WINDOW;
+            if (!err && (s->function == MODBUS_FC_READ_HOLDING ||
+                         s->function == MODBUS_FC_READ_INPUT)) {
+                for (uint16_t i = 0; i < n; i++)
+                    s->data[i] = EC_READ_U16(gw->pdo[IN_DATA0 + i]);
+            }
+            rt_finish(gw, err, n);
+        } else if (cycle - gw->issued > gw->timeout_cycles) {
+            INC(gw->timeouts, 1);
+            rt_finish(gw, -ETIMEDOUT, 0);
+        }
+        return;
+    }
+
+    /* 上一条 (或启动前、超时后残留的命令) 的握手尚未结束：保持 DoCommand = 0 等待 IDLE */
+    if (state != MODBUS_GW_STATE_IDLE) {
+        EC_WRITE_U16(gw->pdo[OUT_DO_COMMAND], 0);
+        return;
+    }
+    uint32_t idx;
+    if (!spsc_ring_pop(gw->submit, &idx))
+        return;
+
+    tx_slot_t *s = &gw->slots[idx];
+    EC_WRITE_U16(gw->pdo[OUT_SLAVE_ID], s->unit);
+    EC_WRITE_U16(gw->pdo[OUT_FUNCTION], s->function);
+    EC_WRITE_U16(gw->pdo[OUT_ADDR], s->addr);
+    EC_WRITE_U16(gw->pdo[OUT_COUNT], s->count);
+    for (uint16_t i = 0; i < MODBUS_GW_WRITE_WINDOW; i++)
+        EC_WRITE_U16(gw->pdo[OUT_DATA0 + i], i < s->count ? s->data[i] : 0);
+    EC_WRITE_U16(gw->pdo[OUT_DO_COMMAND], 1);
+
+    gw->busy = 1;
+    gw->busy_slot = idx;
+    gw->issued = cycle;
+}
+
+/* --- 接口 --- */
+
+/* 校验协议对象的映射；gw 非 NULL 时同时填写其注册表 */
+static int map_pdos(const axis_slave_desc_t *sd, modbus_gw_t *gw, char *err, size_t err_len)
+{
+    for (unsigned int i = 0; i < PDO_COUNT; i++) {
+        int is_out = i < IN_STATE;
+        uint16_t index = (uint16_t)(is_out ? OUT_BASE + i : IN_BASE + (i - IN_STATE));
+        uint8_t sub, bits;
+        ec_direction_t dir;
+        if (pdo_lookup(sd->syncs, index, &sub, &bits, &dir))
+            return gw_fail(err, err_len, -EINVAL, "modbus: 0x%04X not in PDO map of slave %u",
+                           index, sd->position);
+        if (bits != 16 || dir != (is_out ? EC_DIR_OUTPUT : EC_DIR_INPUT))
+            return gw_fail(err, err_len, -EINVAL,
+                           "modbus: 0x%04X on slave %u must be a 16-bit %s", index,
+                           sd->position, is_out ? "output" : "input");
+        if (!gw)
+            continue;
+        ec_pdo_entry_reg_t *r = &gw->regs[i];
+        r->alias = sd->alias;
+        r->position = sd->position;
+        r->vendor_id = sd->vendor_id;
+        r->product_code = sd->product_code;
+        r->index = index;
+        r->subindex = sub;
+        r->offset = &gw->offsets[i];
+        r->bit_position = NULL;
+    }
+    return 0;
+}
+
+int modbus_gw_check(const axis_slave_desc_t *sd, char *err, size_t err_len)
+{
+    if (!sd)
+        return -EINVAL;
+    return map_pdos(sd, NULL, err, err_len);
+}
+
+int modbus_gw_create(const axis_slave_desc_t *sd, uint32_t cycle_us, uint32_t timeout_ms,
+                     modbus_gw_t **out, char *err, size_t err_len)
+{
+    if (!sd || !out || !cycle_us)
+        return -EINVAL;
+
+    modbus_gw_t *gw = calloc(1, sizeof(*gw));
+    if (!gw)
+        return -ENOMEM;
+
+    int r = map_pdos(sd, gw, err, err_len);
+    if (r) {
+        free(gw);
+        return r;
+    }
+
+    if (!timeout_ms)
+        timeout_ms = MODBUS_GW_DEFAULT_TIMEOUT_MS;
+    gw->timeout_cycles = ((uint64_t)timeout_ms * 1000 + cycle_us - 1) / cycle_us;
+    gw->poll_ns = cycle_us * 1000u;
+    for (uint32_t i = 0; i < MODBUS_GW_SLOTS; i++)
+        gw->free_slots[i] = MODBUS_GW_SLOTS - 1 - i;
+    gw->n_free = MODBUS_GW_SLOTS;
+
+    r = spsc_ring_create(MODBUS_GW_SLOTS, sizeof(uint32_t), &gw->submit);
+    if (!r)
+        r = spsc_ring_create(MODBUS_GW_SLOTS, sizeof(uint32_t), &gw->complete);
+    if (r) {
+        spsc_ring_destroy(gw->submit);
+        free(gw);
+        return r;
+    }
+    pthread_mutex_init(&gw->lock, NULL);
+    pthread_cond_init(&gw->cond, NULL);
+    gw->running = 1;
+    r = pthread_create(&gw->thread, NULL, gw_thread, gw);
+    if (r) {
+        gw->running = 0;
+        modbus_gw_destroy(gw);
+        return -r;
+    }
+    gw->started = 1;
+    *out = gw;
+    return 0;
+}
+
+const ec_pdo_entry_reg_t *modbus_gw_regs(const modbus_gw_t *gw)
+{
+    return gw->regs;
+}
+
+int modbus_gw_bind(modbus_gw_t *gw, uint8_t *domain_pd)
+{
+    if (!gw || !domain_pd)
+        return -EINVAL;
+    for (unsigned int i = 0; i < PDO_COUNT; i++)
+        gw->pdo[i] = domain_pd + gw->offsets[i];
+    gw->bound = 1;
+    return 0;
+}
+
+int modbus_gw_submit(modbus_gw_t *gw, modbus_gw_req_t *req)
+{
+    if (!gw || !req || !req->regs || !req->count || req->count > MODBUS_GW_MAX_REGS ||
+        (uint32_t)req->addr + req->count > 0x10000)
+        return -EINVAL;
+    switch (req->function) {
+    case MODBUS_FC_READ_HOLDING:
+    case MODBUS_FC_READ_INPUT:
+    case MODBUS_FC_WRITE_MULTIPLE:
+        break;
+    case MODBUS_FC_WRITE_SINGLE:
+        if (req->count != 1)
+            return -EINVAL;
+        break;
+    default:
+        return -EINVAL;
+    }
+
+    req->status = 0;
+    req->scheduled = 0;
+    req->remaining = req->count;
+    req->next = NULL;
+
+    pthread_mutex_lock(&gw->lock);
+    if (!gw->running) {
+        pthread_mutex_unlock(&gw->lock);
+        return -ESHUTDOWN;
+    }
+    if (gw->tail)
+        gw->tail->next = req;
+    else
+        gw->head = req;
+    gw->tail = req;
+    pthread_cond_signal(&gw->cond);
+    pthread_mutex_unlock(&gw->lock);
+    return 0;
+}
+
+static void sync_done(modbus_gw_req_t *req, void *arg)
+{
+    (void)req;
+    sync_wait_t *w = arg;
+    pthread_mutex_lock(&w->lock);
+    w->done = 1;
+    pthread_cond_signal(&w->cond);
+    pthread_mutex_unlock(&w->lock);
+}
+
+int modbus_gw_transfer(modbus_gw_t *gw, modbus_gw_req_t *req)
+{
+    sync_wait_t w = {.done = 0};
+    pthread_mutex_init(&w.lock, NULL);
+    pthread_cond_init(&w.cond, NULL);
+    req->done = sync_done;
+    req->arg = &w;
+
+    int r = modbus_gw_submit(gw, req);
+    if (!r) {
+        pthread_mutex_lock(&w.lock);
+        while (!w.done)
+            pthread_cond_wait(&w.cond, &w.lock);
+        pthread_mutex_unlock(&w.lock);
+        r = req->status;
+    }
+    pthread_cond_destroy(&w.cond);
+    pthread_mutex_destroy(&w.lock);
+    return r;
+}
+
+void modbus_gw_get_stats(const modbus_gw_t *gw, modbus_gw_stats_t *st)
+{
+    modbus_gw_t *g = (modbus_gw_t *)gw;
+    st->requests = LOAD(g->requests);
+    st->transactions = LOAD(g->transactions);
+    st->registers = LOAD(g->registers);
+    st->merged = LOAD(g->merged);
+    st->errors = LOAD(g->errors);
+    st->timeouts = LOAD(g->timeouts);
+}
+
+void modbus_gw_destroy(modbus_gw_t *gw)
+{
+    if (!gw)
+        return;
+    pthread_mutex_lock(&gw->lock);
+    gw->running = 0;
+    pthread_cond_signal(&gw->cond);
+    pthread_mutex_unlock(&gw->lock);
+    if (gw->started)
+        pthread_join(gw->thread, NULL);
+
+    /* 周期任务已停止：先分发已完成的结果，其余在途事务与未编排的请求一律取消 */
+    uint32_t idx;
+    if (gw->complete) {
+        while (spsc_ring_pop(gw->complete, &idx))
+            complete_slot(gw, idx);
+    }
+    uint8_t used[MODBUS_GW_SLOTS] = {0};
+    for (unsigned int i = 0; i < gw->n_free; i++)
+        used[gw->free_slots[i]] = 1;
+    for (uint32_t i = 0; i < MODBUS_GW_SLOTS; i++) {
+        if (used[i])
+            continue;
+        gw->slots[i].status = -ECANCELED;
+        complete_slot(gw, i);
+    }
+    for (modbus_gw_req_t *r = gw->head, *next; r; r = next) {
+        next = r->next;
+        finish_part(gw, r, (uint16_t)(r->count - r->scheduled), -ECANCELED);
+    }
+
+    spsc_ring_destroy(gw->submit);
+    spsc_ring_destroy(gw->complete);
+    pthread_cond_destroy(&gw->cond);
+    pthread_mutex_destroy(&gw->lock);
+    free(gw);
+}
@@ -0,0 +1,91 @@
+/*
+ * spsc_ring.c
+ *
+ * 单生产者 / 单消费者环，接口说明见 spsc_ring.h。
+ * head 只由生产者推进，tail 只由消费者推进；各自缓存对方的位置，只在看似满/空时重新读取。
+ */
+
+#include "spsc_ring.h"
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct spsc_ring {
+    _Alignas(64) _Atomic uint32_t head;   /* 生产者 */
+    uint32_t                      tail_cache;
+    _Alignas(64) _Atomic uint32_t tail;   /* 消费者 */
+    uint32_t                      head_cache;
+    _Alignas(64) uint32_t         mask;
+    size_t                        elem_size;
+    unsigned char                *buf;
+};
+
+int spsc_ring_create(unsigned int capacity, size_t elem_size, spsc_ring_t **out)
+{
+    if (!out || !capacity || capacity > (1u << 20) || !elem_size)
+        return -EINVAL;
+    uint32_t cap = 1;
+    while (cap < capacity)
+        cap <<= 1;
+
+    spsc_ring_t *r = aligned_alloc(64, sizeof(*r));
+    if (!r)
+        return -ENOMEM;
+    r->buf = calloc(cap, elem_size);
+    if (!r->buf) {
+        free(r);
+        return -ENOMEM;
+    }
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    r->tail_cache = 0;
+    r->head_cache = 0;
+    r->mask = cap - 1;
+    r->elem_size = elem_size;
+    *out = r;
+    return 0;
+}
+
+int spsc_ring_push(spsc_ring_t *r, const void *elem)
+{
+    uint32_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    if (head - r->tail_cache > r->mask) {
+        r->tail_cache = atomic_load_explicit(&r->tail, memory_order_acquire);
+        if (head - r->tail_cache > r->mask)
+            return -ENOSPC;
+    }
+    memcpy(r->buf + (size_t)(head & r->mask) * r->elem_size, elem, r->elem_size);
+    atomic_store_explicit(&r->head, head + 1, memory_order_release);
+    return 0;
+}
+
+int spsc_ring_pop(spsc_ring_t *r, void *elem)
+{
+    uint32_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    if (tail == r->head_cache) {
+        r->head_cache = atomic_load_explicit(&r->head, memory_order_acquire);
+        if (tail == r->head_cache)
+            return 0;
+    }
+    memcpy(elem, r->buf + (size_t)(tail & r->mask) * r->elem_size, r->elem_size);
+    atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+    return 1;
+}
+
+unsigned int spsc_ring_count(const spsc_ring_t *r)
+{
+    spsc_ring_t *m = (spsc_ring_t *)r;
+    return atomic_load_explicit(&m->head, memory_order_acquire) -
+           atomic_load_explicit(&m->tail, memory_order_acquire);
+}
+
+void spsc_ring_destroy(spsc_ring_t *r)
+{
+    if (!r)
+        return;
+    free(r->buf);
+    free(r);
+}
@@ -0,0 +1,53 @@
+/*
+ * status_httpd.c
+ *
+ * 独立运行的状态服务：读取遥测共享内存段，在 8088 端口提供 HTTP / WebSocket 接口。
+ * 与周期任务分属不同进程，应绑定到非 RT 核。
+ *
+ * 用法:
+ * ./status_httpd [端口] [绑定CPU] [遥测段名]
+ * 遥测段名默认 /ecat_telemetry (test_io_raw)；test_all --run 的主站 0 为 /ecat_telemetry.0
+ *
+ * curl http://localhost:8088/status
+ * curl http://localhost:8088/layout
+ * WebSocket: ws://localhost:8088/ws
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "status_server.h"
+
+static volatile sig_atomic_t run = 1;
+
+static void signal_handler(int sig) {
+    (void)sig;
+    run = 0;
+}
+
+int main(int argc, char **argv) {
+    status_server_config_t cfg = {0};
+    cfg.port = argc > 1 ? (uint16_t)strtoul(argv[1], NULL, 0) : STATUS_SERVER_DEFAULT_PORT;
+    cfg.cpu = argc > 2 ? atoi(argv[2]) : -1;
+    cfg.shm_name = argc > 3 ? argv[3] : NULL;
+
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+
+    status_server_t *srv = NULL;
+    int err = status_server_start(&cfg, &srv);
+    if (err) {
+        fprintf(stderr, "Failed to start status server: %s\n", strerror(-err));
+        return -1;
+    }
+    printf("Status server listening on port %u\n", cfg.port);
+
+    while (run)
+        pause();
+
+    status_server_stop(srv);
+    return 0;
+}
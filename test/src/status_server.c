@@ -0,0 +1,920 @@
+/*
+ * status_server.c
+ *
+ * epoll 单线程事件循环：监听 socket、timerfd (流采样节拍)、eventfd (停止信号)
+ * 以及所有客户端连接都注册在同一个 epoll 实例上，所有 fd 均为非阻塞。
+ * 接口说明见 status_server.h。
+ */
+
+#define _GNU_SOURCE
+
+#include "status_server.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "telemetry_shm.h"
+
+#define CLIENT_IN_BUF   4096
+#define EPOLL_BATCH     64
+#define TAG_LISTEN      0
+#define TAG_TIMER       1
+#define TAG_STOP        2
+#define TAG_CLIENT_BASE 3
+
+#define WS_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+enum {
+    CLIENT_FREE = 0,
+    CLIENT_HTTP,     /* 等待 HTTP 请求 */
+    CLIENT_WS,       /* WebSocket 推流中 */
+    CLIENT_CLOSING,  /* 发送完剩余数据后关闭 */
+};
+
+typedef struct {
+    char  *p;
+    size_t len;
+    size_t cap;
+} sbuf_t;
+
+typedef struct {
+    int    fd;
+    int    mode;
+    int    want_out;
+    char   in[CLIENT_IN_BUF];
+    size_t in_len;
+    sbuf_t out;
+    size_t out_head;
+} client_t;
+
+struct status_server {
+    status_server_config_t cfg;
+    char                   shm_name[64];
+    int                    epfd;
+    int                    listen_fd;
+    int                    timer_fd;
+    int                    stop_fd;
+    pthread_t              thread;
+
+    telemetry_reader_t      *rd;
+    const telemetry_field_t *fields;
+    unsigned int             n_fields;
+    uint32_t                *values;
+    uint64_t                 last_cycle;
+    unsigned int             stale_ticks;
+    dev_t                    shm_dev;     /* 已附加段的身份，写端重建后 inode 改变 */
+    ino_t                    shm_ino;
+
+    client_t    *clients;    /* [max_clients] */
+    unsigned int n_ws;
+    sbuf_t       scratch;    /* 单次响应 / 帧组装 */
+    sbuf_t       batch;      /* 当前批次已采样的 JSON 对象 */
+    unsigned int batch_n;
+};
+
+/* ---------------------------------------------------------------------- */
+/* 字符串缓冲 */
+
+static int sb_reserve(sbuf_t *sb, size_t extra)
+{
+    if (sb->len + extra + 1 <= sb->cap)
+        return 0;
+    size_t cap = sb->cap ? sb->cap : 1024;
+    while (cap < sb->len + extra + 1)
+        cap *= 2;
+    char *p = realloc(sb->p, cap);
+    if (!p)
+        return -ENOMEM;
+    sb->p = p;
+    sb->cap = cap;
+    return 0;
+}
+
+static int sb_append(sbuf_t *sb, const void *data, size_t len)
+{
+    if (sb_reserve(sb, len))
+        return -ENOMEM;
+    memcpy(sb->p + sb->len, data, len);
+    sb->len += len;
+    sb->p[sb->len] = '\0';
+    return 0;
+}
+
+static int sb_printf(sbuf_t *sb, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+    if (n < 0 || sb_reserve(sb, (size_t)n))
+        return -ENOMEM;
+    va_start(ap, fmt);
+    vsnprintf(sb->p + sb->len, (size_t)n + 1, fmt, ap);
+    va_end(ap);
+    sb->len += (size_t)n;
+    return 0;
+}
+
+static void sb_json_string(sbuf_t *sb, const char *s)
+{
+    sb_append(sb, "\"", 1);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\')
+            sb_append(sb, "\\", 1);
+        if ((unsigned char)*s >= 0x20)
+            sb_append(sb, s, 1);
+    }
+    sb_append(sb, "\"", 1);
+}
+
+/* ---------------------------------------------------------------------- */
+/* WebSocket 握手所需的 SHA-1 与 Base64 */
+
+static uint32_t rol32(uint32_t v, int n)
+{
+    return (v << n) | (v >> (32 - n));
+}
+
+static void sha1_block(uint32_t h[5], const uint8_t *blk)
+{
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++)
+        w[i] = (uint32_t)blk[i * 4] << 24 | (uint32_t)blk[i * 4 + 1] << 16 |
+               (uint32_t)blk[i * 4 + 2] << 8 | blk[i * 4 + 3];
+    for (int i = 16; i < 80; i++)
+        w[i] = rol32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; i++) {
+        uint32_t f, k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+        uint32_t t = rol32(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = rol32(b, 30);
+        b = a;
+        a = t;
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+}
+
+static void sha1(const uint8_t *data, size_t len, uint8_t out[20])
+{
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    size_t i = 0;
+    for (; i + 64 <= len; i += 64)
+        sha1_block(h, data + i);
+
+    uint8_t tail[128] = {0};
+    size_t rem = len - i;
+    memcpy(tail, data + i, rem);
+    tail[rem] = 0x80;
+    size_t tail_len = rem + 9 <= 64 ? 64 : 128;
+    uint64_t bits = (uint64_t)len * 8;
+    for (int j = 0; j < 8; j++)
+        tail[tail_len - 1 - j] = (uint8_t)(bits >> (8 * j));
+    sha1_block(h, tail);
+    if (tail_len == 128)
+        sha1_block(h, tail + 64);
+
+    for (int j = 0; j < 5; j++) {
+        out[j * 4] = (uint8_t)(h[j] >> 24);
+        out[j * 4 + 1] = (uint8_t)(h[j] >> 16);
+        out[j * 4 + 2] = (uint8_t)(h[j] >> 8);
+        out[j * 4 + 3] = (uint8_t)h[j];
+    }
+}
+
+static void base64(const uint8_t *in, size_t len, char *out)
+{
+    static const char tbl[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t o = 0;
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t v = (uint32_t)in[i] << 16;
+        if (i + 1 < len)
+            v |= (uint32_t)in[i + 1] << 8;
+        if (i + 2 < len)
+            v |= in[i + 2];
+        out[o++] = tbl[(v >> 18) & 0x3F];
+        out[o++] = tbl[(v >> 12) & 0x3F];
+        out[o++] = i + 1 < len ? tbl[(v >> 6) & 0x3F] : '=';
+        out[o++] = i + 2 < len ? tbl[v & 0x3F] : '=';
+    }
+    out[o] = '\0';
+}
+
+/* ---------------------------------------------------------------------- */
+/* 连接管理 */
+
+static void client_close(status_server_t *srv, client_t *c)
+{
+    if (c->mode == CLIENT_FREE)
+        return;
+    if (c->mode == CLIENT_WS)
+        srv->n_ws--;
+    epoll_ctl(srv->epfd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    free(c->out.p);
+    memset(c, 0, sizeof(*c));
+    c->fd = -1;
+}
+
+static void client_update_events(status_server_t *srv, client_t *c, int want_out)
+{
+    if (c->want_out == want_out)
+        return;
+    struct epoll_event ev = {
+        .events = EPOLLIN | EPOLLRDHUP | (want_out ? EPOLLOUT : 0),
+        .data.u64 = TAG_CLIENT_BASE + (uint64_t)(c - srv->clients),
+    };
+    epoll_ctl(srv->epfd, EPOLL_CTL_MOD, c->fd, &ev);
+    c->want_out = want_out;
+}
+
+/* 尽量写出待发送数据；返回 -1 表示连接已关闭 */
+static int client_flush(status_server_t *srv, client_t *c)
+{
+    while (c->out_head < c->out.len) {
+        ssize_t n = send(c->fd, c->out.p + c->out_head, c->out.len - c->out_head,
+                         MSG_NOSIGNAL);
+        if (n > 0) {
+            c->out_head += (size_t)n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            client_update_events(srv, c, 1);
+            return 0;
+        }
+        client_close(srv, c);
+        return -1;
+    }
+    c->out.len = 0;
+    c->out_head = 0;
+    client_update_events(srv, c, 0);
+    if (c->mode == CLIENT_CLOSING) {
+        client_close(srv, c);
+        return -1;
+    }
+    return 0;
+}
+
+/* 入队发送；超过单客户端缓冲上限的慢客户端直接断开 */
+static int client_send(status_server_t *srv, client_t *c, const void *data, size_t len)
+{
+    size_t pending = c->out.len - c->out_head;
+    if (pending + len > srv->cfg.client_buf_limit) {
+        client_close(srv, c);
+        return -1;
+    }
+    if (c->out_head && c->out_head == c->out.len) {
+        c->out.len = 0;
+        c->out_head = 0;
+    } else if (c->out_head > c->out.cap / 2) {
+        memmove(c->out.p, c->out.p + c->out_head, pending);
+        c->out.len = pending;
+        c->out_head = 0;
+    }
+    if (sb_append(&c->out, data, len)) {
+        client_close(srv, c);
+        return -1;
+    }
+    /* 已在等待 EPOLLOUT 时不必立即尝试 */
+    if (c->want_out)
+        return 0;
+    return client_flush(srv, c);
+}
+
+static void ws_frame_header(uint8_t opcode, size_t len, uint8_t *hdr, size_t *hdr_len)
+{
+    hdr[0] = 0x80 | opcode;
+    if (len < 126) {
+        hdr[1] = (uint8_t)len;
+        *hdr_len = 2;
+    } else if (len <= 0xFFFF) {
+        hdr[1] = 126;
+        hdr[2] = (uint8_t)(len >> 8);
+        hdr[3] = (uint8_t)len;
+        *hdr_len = 4;
+    } else {
+        hdr[1] = 127;
+        for (int i = 0; i < 8; i++)
+            hdr[2 + i] = (uint8_t)((uint64_t)len >> (56 - 8 * i));
+        *hdr_len = 10;
+    }
+}
+
+static int ws_send(status_server_t *srv, client_t *c, uint8_t opcode, const void *data,
+                   size_t len)
+{
+    uint8_t hdr[10];
+    size_t hdr_len;
+    ws_frame_header(opcode, len, hdr, &hdr_len);
+    if (client_send(srv, c, hdr, hdr_len))
+        return -1;
+    return client_send(srv, c, data, len);
+}
+
+/* ---------------------------------------------------------------------- */
+/* 快照读取与 JSON 组装 */
+
+static void reader_drop(status_server_t *srv)
+{
+    telemetry_reader_detach(srv->rd);
+    free(srv->values);
+    srv->rd = NULL;
+    srv->values = NULL;
+    srv->fields = NULL;
+    srv->n_fields = 0;
+}
+
+/* 按名字查询当前共享内存段的身份 */
+static int shm_identity(const char *name, dev_t *dev, ino_t *ino)
+{
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0)
+        return -1;
+    struct stat st;
+    int r = fstat(fd, &st);
+    close(fd);
+    if (r < 0)
+        return -1;
+    *dev = st.st_dev;
+    *ino = st.st_ino;
+    return 0;
+}
+
+/*
+ * 保证附加的是名字当前指向的段：写端重启 (shm_unlink + 重新创建) 后旧映射不会再更新，
+ * 此时丢弃旧映射并重新附加。
+ */
+static int reader_ensure(status_server_t *srv)
+{
+    dev_t dev;
+    ino_t ino;
+    if (shm_identity(srv->shm_name, &dev, &ino)) {
+        reader_drop(srv);
+        return -1;
+    }
+    if (srv->rd) {
+        if (dev == srv->shm_dev && ino == srv->shm_ino)
+            return 0;
+        reader_drop(srv);
+    }
+    /* 先取身份再附加：两者之间段被重建时，下一次检查会发现不一致并重新附加 */
+    telemetry_reader_t *rd = NULL;
+    if (telemetry_reader_attach(srv->shm_name, &rd))
+        return -1;
+    unsigned int n = 0;
+    const telemetry_field_t *fields = telemetry_reader_fields(rd, &n);
+    uint32_t *values = calloc(n ? n : 1, sizeof(uint32_t));
+    if (!values) {
+        telemetry_reader_detach(rd);
+        return -1;
+    }
+    srv->rd = rd;
+    srv->fields = fields;
+    srv->n_fields = n;
+    srv->values = values;
+    srv->last_cycle = 0;
+    srv->stale_ticks = 0;
+    srv->shm_dev = dev;
+    srv->shm_ino = ino;
+    return 0;
+}
+
+static void json_snapshot(status_server_t *srv, sbuf_t *sb, const telemetry_stats_t *st)
+{
+    sb_printf(sb,
+              "{\"cycle\":%llu,\"timestamp_ns\":%llu,\"period_ns\":%u,\"period_max_ns\":%u,"
+              "\"exec_ns\":%u,\"exec_max_ns\":%u,\"deadline_misses\":%llu,\"skipped\":%llu,"
+              "\"caught_up\":%llu,\"max_lateness_ns\":%u,\"safe_state\":%u,\"values\":{",
+              (unsigned long long)st->cycle, (unsigned long long)st->timestamp_ns,
+              st->period_ns, st->period_max_ns, st->exec_ns, st->exec_max_ns,
+              (unsigned long long)st->deadline_misses, (unsigned long long)st->skipped,
+              (unsigned long long)st->caught_up, st->max_lateness_ns, st->safe_state);
+    for (unsigned int i = 0; i < srv->n_fields; i++) {
+        if (i)
+            sb_append(sb, ",", 1);
+        sb_json_string(sb, srv->fields[i].name);
+        sb_printf(sb, ":%lld",
+                  (long long)telemetry_value_as_i64(&srv->fields[i], srv->values[i]));
+    }
+    sb_append(sb, "}}", 2);
+}
+
+static void json_layout(status_server_t *srv, sbuf_t *sb)
+{
+    sb_append(sb, "{\"fields\":[", 11);
+    for (unsigned int i = 0; i < srv->n_fields; i++) {
+        const telemetry_field_t *f = &srv->fields[i];
+        if (i)
+            sb_append(sb, ",", 1);
+        sb_append(sb, "{\"name\":", 8);
+        sb_json_string(sb, f->name);
+        sb_printf(sb, ",\"slave\":%u,\"index\":%u,\"subindex\":%u,\"type\":%u}",
+                  f->slave, f->index, f->subindex, f->type);
+    }
+    sb_append(sb, "]}", 2);
+}
+
+/* ---------------------------------------------------------------------- */
+/* HTTP */
+
+static void http_respond(status_server_t *srv, client_t *c, const char *status,
+                         const char *body, size_t body_len)
+{
+    char hdr[256];
+    int n = snprintf(hdr, sizeof(hdr),
+                     "HTTP/1.1 %s\r\n"
+                     "Content-Type: application/json\r\n"
+                     "Content-Length: %zu\r\n"
+                     "Access-Control-Allow-Origin: *\r\n"
+                     "Cache-Control: no-store\r\n"
+                     "Connection: close\r\n\r\n",
+                     status, body_len);
+    if (client_send(srv, c, hdr, (size_t)n) || client_send(srv, c, body, body_len))
+        return;
+    c->mode = CLIENT_CLOSING;
+    if (!c->want_out)
+        client_flush(srv, c);
+}
+
+/* 在请求头中查找字段值 (大小写不敏感)，返回值长度，未找到返回 0 */
+static size_t http_header(const char *req, const char *name, const char **val)
+{
+    size_t name_len = strlen(name);
+    const char *line = strstr(req, "\r\n");
+    while (line && line[2] != '\r') {
+        line += 2;
+        if (!strncasecmp(line, name, name_len) && line[name_len] == ':') {
+            const char *v = line + name_len + 1;
+            while (*v == ' ' || *v == '\t')
+                v++;
+            const char *end = strstr(v, "\r\n");
+            if (!end)
+                return 0;
+            while (end > v && (end[-1] == ' ' || end[-1] == '\t'))
+                end--;
+            *val = v;
+            return (size_t)(end - v);
+        }
+        line = strstr(line, "\r\n");
+    }
+    return 0;
+}
+
+static void http_handle(status_server_t *srv, client_t *c)
+{
+    char *req = c->in;
+    char path[128] = "";
+    if (sscanf(req, "GET %127s HTTP/1.", path) != 1) {
+        static const char body[] = "{\"error\":\"method not allowed\"}";
+        http_respond(srv, c, "405 Method Not Allowed", body, sizeof(body) - 1);
+        return;
+    }
+    char *q = strchr(path, '?');
+    if (q)
+        *q = '\0';
+
+    if (!strcmp(path, "/ws")) {
+        const char *key = NULL;
+        const char *upgrade = NULL;
+        size_t key_len = http_header(req, "Sec-WebSocket-Key", &key);
+        size_t up_len = http_header(req, "Upgrade", &upgrade);
+        if (!key_len || key_len > 64 || up_len != 9 || strncasecmp(upgrade, "websocket", 9)) {
+            static const char body[] = "{\"error\":\"websocket upgrade required\"}";
+            http_respond(srv, c, "400 Bad Request", body, sizeof(body) - 1);
+            return;
+        }
+        char concat[128];
+        memcpy(concat, key, key_len);
+        memcpy(concat + key_len, WS_GUID, sizeof(WS_GUID) - 1);
+        uint8_t digest[20];
+        sha1((const uint8_t *)concat, key_len + sizeof(WS_GUID) - 1, digest);
+        char accept[32];
+        base64(digest, sizeof(digest), accept);
+
+        char resp[256];
+        int n = snprintf(resp, sizeof(resp),
+                         "HTTP/1.1 101 Switching Protocols\r\n"
+                         "Upgrade: websocket\r\n"
+                         "Connection: Upgrade\r\n"
+                         "Sec-WebSocket-Accept: %s\r\n\r\n",
+                         accept);
+        /* 只去掉握手请求，与握手同一次读到的客户端帧保留给 ws_handle_input() */
+        size_t used = (size_t)(strstr(req, "\r\n\r\n") + 4 - req);
+        memmove(c->in, c->in + used, c->in_len - used);
+        c->in_len -= used;
+        c->in[c->in_len] = '\0';
+        c->mode = CLIENT_WS;
+        srv->n_ws++;
+        client_send(srv, c, resp, (size_t)n);
+        return;
+    }
+
+    if (!strcmp(path, "/") || !strcmp(path, "/status") || !strcmp(path, "/layout")) {
+        telemetry_stats_t st;
+        if (reader_ensure(srv) || telemetry_reader_read(srv->rd, &st, srv->values)) {
+            static const char body[] = "{\"error\":\"telemetry unavailable\"}";
+            http_respond(srv, c, "503 Service Unavailable", body, sizeof(body) - 1);
+            return;
+        }
+        srv->scratch.len = 0;
+        if (!strcmp(path, "/layout"))
+            json_layout(srv, &srv->scratch);
+        else
+            json_snapshot(srv, &srv->scratch, &st);
+        http_respond(srv, c, "200 OK", srv->scratch.p, srv->scratch.len);
+        return;
+    }
+
+    static const char body[] = "{\"error\":\"not found\"}";
+    http_respond(srv, c, "404 Not Found", body, sizeof(body) - 1);
+}
+
+/* 解析客户端发来的 WebSocket 帧：只处理 close / ping，其余丢弃 */
+static void ws_handle_input(status_server_t *srv, client_t *c)
+{
+    size_t pos = 0;
+    while (c->in_len - pos >= 2) {
+        const uint8_t *f = (const uint8_t *)c->in + pos;
+        uint8_t opcode = f[0] & 0x0F;
+        int masked = f[1] & 0x80;
+        uint64_t len = f[1] & 0x7F;
+        size_t hdr = 2;
+        if (len == 126) {
+            if (c->in_len - pos < 4)
+                break;
+            len = (uint64_t)f[2] << 8 | f[3];
+            hdr = 4;
+        } else if (len == 127) {
+            /* 客户端不应发送超大帧 */
+            client_close(srv, c);
+            return;
+        }
+        if (masked)
+            hdr += 4;
+        if (hdr + len > CLIENT_IN_BUF) {
+            client_close(srv, c);
+            return;
+        }
+        if (c->in_len - pos < hdr + len)
+            break;
+
+        uint8_t *payload = (uint8_t *)c->in + pos + hdr;
+        if (masked) {
+            const uint8_t *mask = payload - 4;
+            for (uint64_t i = 0; i < len; i++)
+                payload[i] ^= mask[i & 3];
+        }
+        pos += hdr + (size_t)len;
+
+        if (opcode == 0x8) {
+            ws_send(srv, c, 0x8, NULL, 0);
+            if (c->mode == CLIENT_FREE)
+                return;
+            srv->n_ws--;
+            c->mode = CLIENT_CLOSING;
+            if (!c->want_out)
+                client_flush(srv, c);
+            return;
+        }
+        if (opcode == 0x9 && ws_send(srv, c, 0xA, payload, (size_t)len))
+            return;
+    }
+    memmove(c->in, c->in + pos, c->in_len - pos);
+    c->in_len -= pos;
+}
+
+static void client_readable(status_server_t *srv, client_t *c)
+{
+    for (;;) {
+        if (c->in_len >= CLIENT_IN_BUF - 1) {
+            /* 请求头过大 */
+            client_close(srv, c);
+            return;
+        }
+        ssize_t n = recv(c->fd, c->in + c->in_len, CLIENT_IN_BUF - 1 - c->in_len, 0);
+        if (n > 0) {
+            c->in_len += (size_t)n;
+            c->in[c->in_len] = '\0';
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            client_close(srv, c);
+            return;
+        }
+
+        if (c->mode == CLIENT_HTTP && strstr(c->in, "\r\n\r\n")) {
+            http_handle(srv, c);
+            if (c->mode != CLIENT_WS)
+                return;
+        }
+        if (c->mode == CLIENT_WS) {
+            ws_handle_input(srv, c);
+            if (c->mode != CLIENT_WS)
+                return;
+        }
+        if (c->mode == CLIENT_CLOSING) {
+            /* 关闭前的数据一律丢弃 */
+            c->in_len = 0;
+        }
+    }
+}
+
+static void accept_clients(status_server_t *srv)
+{
+    for (;;) {
+        int fd = accept4(srv->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        client_t *c = NULL;
+        for (unsigned int i = 0; i < srv->cfg.max_clients; i++) {
+            if (srv->clients[i].mode == CLIENT_FREE) {
+                c = &srv->clients[i];
+                break;
+            }
+        }
+        if (!c) {
+            close(fd);
+            continue;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        memset(c, 0, sizeof(*c));
+        c->fd = fd;
+        c->mode = CLIENT_HTTP;
+        struct epoll_event ev = {
+            .events = EPOLLIN | EPOLLRDHUP,
+            .data.u64 = TAG_CLIENT_BASE + (uint64_t)(c - srv->clients),
+        };
+        if (epoll_ctl(srv->epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            close(fd);
+            c->mode = CLIENT_FREE;
+            c->fd = -1;
+        }
+    }
+}
+
+/* ---------------------------------------------------------------------- */
+/* 流采样 */
+
+static void stream_tick(status_server_t *srv)
+{
+    uint64_t expirations;
+    if (read(srv->timer_fd, &expirations, sizeof(expirations)) < 0)
+        return;
+    /* 只有 HTTP 客户端时也要检查，否则 /status 会一直读已删除的旧段 */
+    if (srv->rd)
+        reader_ensure(srv);
+    if (!srv->n_ws) {
+        srv->batch.len = 0;
+        srv->batch_n = 0;
+        return;
+    }
+    if (reader_ensure(srv))
+        return;
+
+    telemetry_stats_t st;
+    if (telemetry_reader_read(srv->rd, &st, srv->values))
+        return;
+    if (st.cycle == srv->last_cycle) {
+        /* 写端停止超过 1s：可能已重建共享内存段，重新附加 */
+        if (++srv->stale_ticks * srv->cfg.stream_period_ms > 1000)
+            reader_drop(srv);
+        return;
+    }
+    srv->last_cycle = st.cycle;
+    srv->stale_ticks = 0;
+
+    sb_append(&srv->batch, srv->batch_n ? "," : "", srv->batch_n ? 1 : 0);
+    json_snapshot(srv, &srv->batch, &st);
+    if (++srv->batch_n < srv->cfg.batch)
+        return;
+
+    srv->scratch.len = 0;
+    sb_append(&srv->scratch, "{\"samples\":[", 12);
+    sb_append(&srv->scratch, srv->batch.p, srv->batch.len);
+    sb_append(&srv->scratch, "]}", 2);
+    srv->batch.len = 0;
+    srv->batch_n = 0;
+
+    for (unsigned int i = 0; i < srv->cfg.max_clients; i++) {
+        client_t *c = &srv->clients[i];
+        if (c->mode == CLIENT_WS)
+            ws_send(srv, c, 0x1, srv->scratch.p, srv->scratch.len);
+    }
+}
+
+/* ---------------------------------------------------------------------- */
+/* 事件循环 */
+
+static void *server_thread(void *arg)
+{
+    status_server_t *srv = arg;
+    struct epoll_event events[EPOLL_BATCH];
+
+    for (;;) {
+        int n = epoll_wait(srv->epfd, events, EPOLL_BATCH, -1);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            uint64_t tag = events[i].data.u64;
+            if (tag == TAG_STOP)
+                return NULL;
+            if (tag == TAG_LISTEN) {
+                accept_clients(srv);
+                continue;
+            }
+            if (tag == TAG_TIMER) {
+                stream_tick(srv);
+                continue;
+            }
+            client_t *c = &srv->clients[tag - TAG_CLIENT_BASE];
+            if (c->mode == CLIENT_FREE)
+                continue;
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                client_close(srv, c);
+                continue;
+            }
+            if ((events[i].events & EPOLLOUT) && client_flush(srv, c))
+                continue;
+            if (events[i].events & (EPOLLIN | EPOLLRDHUP))
+                client_readable(srv, c);
+        }
+    }
+    return NULL;
+}
+
+static int epoll_add(int epfd, int fd, uint64_t tag)
+{
+    struct epoll_event ev = {.events = EPOLLIN, .data.u64 = tag};
+    return epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+static void server_free(status_server_t *srv)
+{
+    if (srv->clients) {
+        for (unsigned int i = 0; i < srv->cfg.max_clients; i++)
+            client_close(srv, &srv->clients[i]);
+    }
+    if (srv->listen_fd >= 0)
+        close(srv->listen_fd);
+    if (srv->timer_fd >= 0)
+        close(srv->timer_fd);
+    if (srv->stop_fd >= 0)
+        close(srv->stop_fd);
+    if (srv->epfd >= 0)
+        close(srv->epfd);
+    reader_drop(srv);
+    free(srv->clients);
+    free(srv->scratch.p);
+    free(srv->batch.p);
+    free(srv);
+}
+
+int status_server_start(const status_server_config_t *cfg, status_server_t **out)
+{
+    if (!out)
+        return -EINVAL;
+
+    status_server_t *srv = calloc(1, sizeof(*srv));
+    if (!srv)
+        return -ENOMEM;
+    srv->epfd = srv->listen_fd = srv->timer_fd = srv->stop_fd = -1;
+    if (cfg)
+        srv->cfg = *cfg;
+    else
+        srv->cfg.cpu = -1;
+    if (!srv->cfg.port)
+        srv->cfg.port = STATUS_SERVER_DEFAULT_PORT;
+    if (!srv->cfg.stream_period_ms)
+        srv->cfg.stream_period_ms = 20;
+    if (!srv->cfg.batch)
+        srv->cfg.batch = 5;
+    if (!srv->cfg.max_clients)
+        srv->cfg.max_clients = 64;
+    if (!srv->cfg.client_buf_limit)
+        srv->cfg.client_buf_limit = 256 * 1024;
+    strncpy(srv->shm_name, srv->cfg.shm_name ? srv->cfg.shm_name : TELEMETRY_SHM_DEFAULT_NAME,
+            sizeof(srv->shm_name) - 1);
+    srv->cfg.shm_name = srv->shm_name;
+
+    int err = 0;
+    srv->clients = calloc(srv->cfg.max_clients, sizeof(client_t));
+    if (!srv->clients) {
+        err = -ENOMEM;
+        goto fail;
+    }
+    for (unsigned int i = 0; i < srv->cfg.max_clients; i++)
+        srv->clients[i].fd = -1;
+
+    srv->epfd = epoll_create1(EPOLL_CLOEXEC);
+    srv->stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    srv->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    srv->listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (srv->epfd < 0 || srv->stop_fd < 0 || srv->timer_fd < 0 || srv->listen_fd < 0) {
+        err = -errno;
+        goto fail;
+    }
+
+    int one = 1;
+    setsockopt(srv->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(srv->cfg.port),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    if (bind(srv->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(srv->listen_fd, 64) < 0) {
+        err = -errno;
+        goto fail;
+    }
+
+    long period_ns = (long)srv->cfg.stream_period_ms * 1000000L;
+    struct itimerspec its = {
+        .it_interval = {period_ns / 1000000000L, period_ns % 1000000000L},
+        .it_value = {period_ns / 1000000000L, period_ns % 1000000000L},
+    };
+    if (timerfd_settime(srv->timer_fd, 0, &its, NULL) < 0 ||
+        epoll_add(srv->epfd, srv->listen_fd, TAG_LISTEN) < 0 ||
+        epoll_add(srv->epfd, srv->timer_fd, TAG_TIMER) < 0 ||
+        epoll_add(srv->epfd, srv->stop_fd, TAG_STOP) < 0) {
+        err = -errno;
+        goto fail;
+    }
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if (srv->cfg.cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(srv->cfg.cpu, &set);
+        pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+    }
+    err = -pthread_create(&srv->thread, &attr, server_thread, srv);
+    pthread_attr_destroy(&attr);
+    if (err)
+        goto fail;
+
+    *out = srv;
+    return 0;
+
+fail:
+    server_free(srv);
+    return err;
+}
+
+void status_server_stop(status_server_t *srv)
+{
+    if (!srv)
+        return;
+    uint64_t one = 1;
+    if (write(srv->stop_fd, &one, sizeof(one)) == sizeof(one))
+        pthread_join(srv->thread, NULL);
+    server_free(srv);
+}
@@ -0,0 +1,81 @@
+/*
+ * telemetry_dump.c
+ *
+ * 遥测共享内存读端示例：附加到 /ecat_telemetry (或命令行指定的段名)，
+ * 按固定间隔打印一致快照。读端不会影响主站周期。
+ *
+ * 用法:
+ * ./telemetry_dump [段名] [间隔ms]
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "telemetry_shm.h"
+
+static volatile sig_atomic_t run = 1;
+
+static void signal_handler(int sig) {
+    (void)sig;
+    run = 0;
+}
+
+int main(int argc, char **argv) {
+    const char *name = argc > 1 ? argv[1] : TELEMETRY_SHM_DEFAULT_NAME;
+    long interval_ms = argc > 2 ? strtol(argv[2], NULL, 0) : 500;
+
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+
+    telemetry_reader_t *rd = NULL;
+    int err = telemetry_reader_attach(name, &rd);
+    if (err) {
+        fprintf(stderr, "Failed to attach %s: %s\n", name, strerror(-err));
+        return -1;
+    }
+
+    unsigned int n = 0;
+    const telemetry_field_t *fields = telemetry_reader_fields(rd, &n);
+    uint32_t *values = calloc(n ? n : 1, sizeof(uint32_t));
+    if (!values) {
+        telemetry_reader_detach(rd);
+        return -1;
+    }
+
+    printf("Attached %s: %u fields\n", name, n);
+    for (unsigned int i = 0; i < n; i++) {
+        printf("  [%2u] %-24s slave %u 0x%04X:%02X\n", i, fields[i].name,
+               fields[i].slave, fields[i].index, fields[i].subindex);
+    }
+
+    struct timespec ts = {interval_ms / 1000, (interval_ms % 1000) * 1000000L};
+    while (run) {
+        telemetry_stats_t stats;
+        err = telemetry_reader_read(rd, &stats, values);
+        if (err) {
+            fprintf(stderr, "Snapshot read failed: %s\n", strerror(-err));
+        } else {
+            printf("cycle %" PRIu64 " period %u ns (max %u) exec %u ns (max %u)\n",
+                   stats.cycle, stats.period_ns, stats.period_max_ns,
+                   stats.exec_ns, stats.exec_max_ns);
+            printf("  deadline misses %" PRIu64 " skipped %" PRIu64 " caught up %" PRIu64
+                   " max lateness %u ns%s\n",
+                   stats.deadline_misses, stats.skipped, stats.caught_up,
+                   stats.max_lateness_ns, stats.safe_state ? " SAFE STATE" : "");
+            for (unsigned int i = 0; i < n; i++) {
+                printf("  %-24s %" PRId64 " (0x%08X)\n", fields[i].name,
+                       telemetry_value_as_i64(&fields[i], values[i]), values[i]);
+            }
+        }
+        nanosleep(&ts, NULL);
+    }
+
+    free(values);
+    telemetry_reader_detach(rd);
+    return 0;
+}
@@ -0,0 +1,338 @@
+/*
+ * telemetry_shm.c
+ *
+ * 实时遥测共享内存段的写端与读端实现，接口说明见 telemetry_shm.h。
+ *
+ * seqlock 约定 (单写者)：
+ *   写端：seq+1 (奇数) -> release 栅栏 -> 写 payload -> seq+1 (偶数, release)
+ *   读端：读 seq (acquire, 需为偶数) -> 复制 payload -> acquire 栅栏 -> 再读 seq，两次一致则快照有效
+ */
+
+#include "telemetry_shm.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ecrt.h"
+
+#define READ_RETRY_MAX 64
+
+struct telemetry_shm {
+    char                    name[64];
+    telemetry_shm_header_t *hdr;
+    size_t                  size;
+    uint8_t                *payload;
+    unsigned int            n_fields;
+    unsigned int            decimation;
+    unsigned int            countdown;
+    const unsigned int    **pd_offset;  /* [n_fields] */
+    uint8_t                *type;       /* [n_fields] */
+};
+
+/*
+ * 读端只信任 attach 时校验过的布局：段大小与字段数缓存在本地，之后只从共享内存读取 seq 与
+ * 负载内容 (段头位于其他进程可写的共享内存中)。
+ */
+struct telemetry_reader {
+    const telemetry_shm_header_t *hdr;
+    size_t                        size;          /* 映射长度 */
+    unsigned int                  field_count;
+    const telemetry_field_t      *fields;
+    const uint8_t                *payload;
+};
+
+static size_t align_up(size_t v, size_t a)
+{
+    return (v + a - 1) & ~(a - 1);
+}
+
+int telemetry_shm_create(const char *name, const telemetry_source_t *sources,
+                         unsigned int n_sources, unsigned int decimation,
+                         unsigned int cycle_us, telemetry_shm_t **out)
+{
+    if (!name || !out || (n_sources && !sources))
+        return -EINVAL;
+
+    telemetry_shm_t *tlm = calloc(1, sizeof(*tlm));
+    if (!tlm)
+        return -ENOMEM;
+
+    size_t table_off = align_up(sizeof(telemetry_shm_header_t), 64);
+    size_t payload_off = align_up(table_off + n_sources * sizeof(telemetry_field_t), 64);
+    size_t payload_size = sizeof(telemetry_stats_t) + n_sources * sizeof(uint32_t);
+    size_t size = align_up(payload_off + payload_size, 4096);
+
+    tlm->pd_offset = calloc(n_sources ? n_sources : 1, sizeof(*tlm->pd_offset));
+    tlm->type = calloc(n_sources ? n_sources : 1, sizeof(*tlm->type));
+    if (!tlm->pd_offset || !tlm->type) {
+        telemetry_shm_destroy(tlm);
+        return -ENOMEM;
+    }
+    strncpy(tlm->name, name, sizeof(tlm->name) - 1);
+
+    /*
+     * 先删除旧段再独占创建：重启的写端总是得到新的 inode，仍映射旧段的读端看到的布局不会被
+     * ftruncate / memset 改写 (否则更多的字段会越过读端按旧字段数分配的缓冲区，更小的段会
+     * 让读端访问越界而收到 SIGBUS)。读端按 inode 变化重新 attach。
+     */
+    if (shm_unlink(name) < 0 && errno != ENOENT) {
+        int err = -errno;
+        telemetry_shm_destroy(tlm);
+        return err;
+    }
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        int err = -errno;
+        telemetry_shm_destroy(tlm);
+        return err;
+    }
+    if (ftruncate(fd, (off_t)size) < 0) {
+        int err = -errno;
+        close(fd);
+        telemetry_shm_destroy(tlm);
+        return err;
+    }
+    void *mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        int err = -errno;
+        telemetry_shm_destroy(tlm);
+        return err;
+    }
+    tlm->hdr = mem;
+    tlm->size = size;
+    /* 周期任务中不允许缺页 */
+    if (mlock(mem, size) < 0) {
+        int err = -errno;
+        telemetry_shm_destroy(tlm);
+        return err;
+    }
+    memset(mem, 0, size);
+
+    tlm->payload = (uint8_t *)mem + payload_off;
+    tlm->n_fields = n_sources;
+    tlm->decimation = decimation ? decimation : 1;
+    tlm->countdown = 0;
+
+    telemetry_field_t *fields = (telemetry_field_t *)((uint8_t *)mem + table_off);
+    for (unsigned int i = 0; i < n_sources; i++) {
+        strncpy(fields[i].name, sources[i].name ? sources[i].name : "",
+                TELEMETRY_FIELD_NAME_LEN - 1);
+        fields[i].slave = sources[i].slave;
+        fields[i].index = sources[i].index;
+        fields[i].subindex = sources[i].subindex;
+        fields[i].type = (uint8_t)sources[i].type;
+        tlm->pd_offset[i] = sources[i].pd_offset;
+        tlm->type[i] = (uint8_t)sources[i].type;
+    }
+
+    telemetry_shm_header_t *hdr = tlm->hdr;
+    hdr->version = TELEMETRY_SHM_VERSION;
+    hdr->segment_size = (uint32_t)size;
+    hdr->field_count = n_sources;
+    hdr->field_table_offset = (uint32_t)table_off;
+    hdr->payload_offset = (uint32_t)payload_off;
+    hdr->payload_size = (uint32_t)payload_size;
+    hdr->decimation = tlm->decimation;
+    hdr->cycle_us = cycle_us;
+    atomic_store_explicit(&hdr->seq, 0, memory_order_relaxed);
+    /* 魔数最后写入：读端看到魔数即表示描述区已完整 */
+    atomic_thread_fence(memory_order_release);
+    hdr->magic = TELEMETRY_SHM_MAGIC;
+
+    *out = tlm;
+    return 0;
+}
+
+void telemetry_shm_publish(telemetry_shm_t *tlm, const uint8_t *domain_pd,
+                           const telemetry_stats_t *stats)
+{
+    if (!tlm || !domain_pd)
+        return;
+    if (tlm->countdown) {
+        tlm->countdown--;
+        return;
+    }
+    tlm->countdown = tlm->decimation - 1;
+
+    telemetry_shm_header_t *hdr = tlm->hdr;
+    uint32_t seq = atomic_load_explicit(&hdr->seq, memory_order_relaxed);
+    atomic_store_explicit(&hdr->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    if (stats)
+        memcpy(tlm->payload, stats, sizeof(*stats));
+    uint32_t *values = (uint32_t *)(tlm->payload + sizeof(telemetry_stats_t));
+    for (unsigned int i = 0; i < tlm->n_fields; i++) {
+        const uint8_t *p = domain_pd + *tlm->pd_offset[i];
+        switch (tlm->type[i]) {
+        case TELEMETRY_U8:
+        case TELEMETRY_S8:
+            values[i] = EC_READ_U8(p);
+            break;
+        case TELEMETRY_U16:
+        case TELEMETRY_S16:
+            values[i] = EC_READ_U16(p);
+            break;
+        default:
+            values[i] = EC_READ_U32(p);
+            break;
+        }
+    }
+
+    atomic_store_explicit(&hdr->seq, seq + 2, memory_order_release);
+}
+
+void telemetry_shm_destroy(telemetry_shm_t *tlm)
+{
+    if (!tlm)
+        return;
+    if (tlm->hdr) {
+        munmap(tlm->hdr, tlm->size);
+        shm_unlink(tlm->name);
+    }
+    free(tlm->pd_offset);
+    free(tlm->type);
+    free(tlm);
+}
+
+static int layout_fits(const telemetry_shm_header_t *hdr, const uint8_t *base, size_t size)
+{
+    uint64_t table_end = (uint64_t)hdr->field_table_offset +
+                         (uint64_t)hdr->field_count * sizeof(telemetry_field_t);
+    uint64_t payload_need = sizeof(telemetry_stats_t) +
+                            (uint64_t)hdr->field_count * sizeof(uint32_t);
+    if (hdr->field_table_offset < sizeof(telemetry_shm_header_t) || table_end > size)
+        return 0;
+    if (hdr->payload_offset < table_end || hdr->payload_size < payload_need ||
+        (uint64_t)hdr->payload_offset + hdr->payload_size > size)
+        return 0;
+    /* 读端按 uint32 / 结构体直接访问，偏移须保持写端的对齐 */
+    if (hdr->field_table_offset % _Alignof(telemetry_field_t) ||
+        hdr->payload_offset % _Alignof(telemetry_stats_t))
+        return 0;
+    /* 字段名按 C 字符串输出 */
+    const telemetry_field_t *fields =
+        (const telemetry_field_t *)(base + hdr->field_table_offset);
+    for (uint32_t i = 0; i < hdr->field_count; i++)
+        if (!memchr(fields[i].name, '\0', sizeof(fields[i].name)))
+            return 0;
+    return 1;
+}
+
+int telemetry_reader_attach(const char *name, telemetry_reader_t **out)
+{
+    if (!name || !out)
+        return -EINVAL;
+
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0)
+        return -errno;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        int err = -errno;
+        close(fd);
+        return err;
+    }
+    if ((size_t)st.st_size < sizeof(telemetry_shm_header_t)) {
+        close(fd);
+        return -ENODATA;
+    }
+    void *mem = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED)
+        return -errno;
+
+    const telemetry_shm_header_t *hdr = mem;
+    if (hdr->magic != TELEMETRY_SHM_MAGIC) {
+        munmap(mem, (size_t)st.st_size);
+        return -EPROTO;
+    }
+    atomic_thread_fence(memory_order_acquire);
+    /* 段头复制一份后校验与使用，校验之后共享内存中的段头再变化也不影响本读端 */
+    telemetry_shm_header_t h;
+    memcpy(&h, hdr, offsetof(telemetry_shm_header_t, seq));
+    /* 描述区来自其他进程，偏移与字段数须落在映射范围内，截断或外来的段直接拒绝 */
+    if (h.version != TELEMETRY_SHM_VERSION || h.segment_size > (size_t)st.st_size ||
+        !layout_fits(&h, mem, (size_t)st.st_size)) {
+        munmap(mem, (size_t)st.st_size);
+        return -EPROTO;
+    }
+
+    telemetry_reader_t *rd = calloc(1, sizeof(*rd));
+    if (!rd) {
+        munmap(mem, (size_t)st.st_size);
+        return -ENOMEM;
+    }
+    rd->hdr = hdr;
+    rd->size = (size_t)st.st_size;
+    rd->field_count = h.field_count;
+    rd->fields = (const telemetry_field_t *)((const uint8_t *)mem + h.field_table_offset);
+    rd->payload = (const uint8_t *)mem + h.payload_offset;
+    *out = rd;
+    return 0;
+}
+
+const telemetry_field_t *telemetry_reader_fields(const telemetry_reader_t *rd,
+                                                 unsigned int *count)
+{
+    if (count)
+        *count = rd ? rd->field_count : 0;
+    return rd ? rd->fields : NULL;
+}
+
+int telemetry_reader_read(const telemetry_reader_t *rd, telemetry_stats_t *stats,
+                          uint32_t *values)
+{
+    if (!rd)
+        return -EINVAL;
+
+    const telemetry_shm_header_t *hdr = rd->hdr;
+    /* 只读映射上的原子读：seq 仅由写端修改 */
+    _Atomic uint32_t *seqp = (_Atomic uint32_t *)&hdr->seq;
+    size_t values_size = rd->field_count * sizeof(uint32_t);
+
+    for (int retry = 0; retry < READ_RETRY_MAX; retry++) {
+        uint32_t s1 = atomic_load_explicit(seqp, memory_order_acquire);
+        if (s1 & 1u)
+            continue;
+        if (stats)
+            memcpy(stats, rd->payload, sizeof(*stats));
+        if (values)
+            memcpy(values, rd->payload + sizeof(telemetry_stats_t), values_size);
+        atomic_thread_fence(memory_order_acquire);
+        uint32_t s2 = atomic_load_explicit(seqp, memory_order_relaxed);
+        if (s1 == s2)
+            return 0;
+    }
+    return -EAGAIN;
+}
+
+int64_t telemetry_value_as_i64(const telemetry_field_t *field, uint32_t raw)
+{
+    switch (field->type) {
+    case TELEMETRY_S8:
+        return (int8_t)raw;
+    case TELEMETRY_S16:
+        return (int16_t)raw;
+    case TELEMETRY_S32:
+        return (int32_t)raw;
+    default:
+        return raw;
+    }
+}
+
+void telemetry_reader_detach(telemetry_reader_t *rd)
+{
+    if (!rd)
+        return;
+    munmap((void *)rd->hdr, rd->size);
+    free(rd);
+}
@@ -1,9 +1,249 @@
 #include "test_all.h"
 
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
 
-int main ()
+#include "analog_pipeline.h"
+#include "axis_config.h"
+#include "axis_table.h"
+#include "config_reload.h"
+#include "di_edge.h"
+#include "master_group.h"
+#include "modbus_gateway.h"
+
+/* test_all.h 描述的总线布局 (厂商/产品码见各从站注释) */
+static const axis_slave_desc_t bus_slaves[] = {
+    {0, 0, 0x00000025, 0x00000530, slave_0_syncs}, /* INEXBOT-IO-R4 */
+    {0, 1, 0x000116c7, 0x003e0402, slave_1_syncs}, /* HCFA X3E */
+    {0, 2, 0x000116c7, 0x003e0402, slave_2_syncs}, /* HCFA X3E */
+    {0, 3, 0x000116c7, 0x003e0402, slave_3_syncs}, /* HCFA X3E */
+    {0, 4, 0x0000001a, 0x50440200, slave_4_syncs}, /* Hans Robot */
+    {0, 5, 0x0000001a, 0x50440200, slave_5_syncs}, /* Hans Robot */
+    {0, 6, 0x0000001a, 0x50440200, slave_6_syncs}, /* Hans Robot */
+    {0, 7, 0x00201911, 0x10003201, slave_7_syncs}, /* F2838x */
+};
+
+#define N_BUS_SLAVES (sizeof(bus_slaves) / sizeof(bus_slaves[0]))
+#define TELEMETRY_DECIMATION 1  /* --run：每周期发布一次遥测快照 */
+
+static volatile sig_atomic_t run = 1;
+
+static void signal_handler(int sig) {
+    (void)sig;
+    run = 0;
+}
+
+/* test_all.h 只描述一条总线：按各主站配置的从站 id 从 bus_slaves 中截取该主站的布局 */
+static unsigned int build_buses(const axis_config_table_t *cfg,
+                                axis_slave_desc_t descs[][N_BUS_SLAVES], master_bus_t *buses)
 {
+    for (unsigned int m = 0; m < cfg->n_masters; m++) {
+        unsigned int n = 0;
+        for (unsigned int s = 0; s < N_BUS_SLAVES; s++) {
+            for (unsigned int i = 0; i < cfg->n_slaves; i++) {
+                if (cfg->slaves[i].master == cfg->masters[m].index &&
+                    cfg->slaves[i].id == bus_slaves[s].position) {
+                    descs[m][n++] = bus_slaves[s];
+                    break;
+                }
+            }
+        }
+        buses[m].master = cfg->masters[m].index;
+        buses[m].slaves = descs[m];
+        buses[m].n_slaves = n;
+    }
+    return cfg->n_masters;
+}
+
+/*
+ * --run：按配置启动 master_group (每个主站一个周期线程)，接入配置热加载，arm 全部探针，
+ * 把各主站的轴状态发布到遥测段 TELEMETRY_SHM_DEFAULT_NAME.<主站编号> (看板与 status_server
+ * 按该段名读取)，每秒打印各主站的调度统计、诊断事件、探针捕获与 Modbus 网关统计，Ctrl+C 退出。
+ * 不发布设定值，周期任务只维持通信，不会让轴运动。
+ */
+static int run_group(const char *path, const axis_config_table_t *cfg)
+{
+    axis_slave_desc_t descs[AXIS_CONFIG_MAX_MASTERS][N_BUS_SLAVES];
+    master_bus_t buses[AXIS_CONFIG_MAX_MASTERS];
+    unsigned int n_buses = build_buses(cfg, descs, buses);
+    char err[256];
+
+    master_group_t *g = NULL;
+    int r = master_group_create(cfg, buses, n_buses, NULL, NULL, &g, err, sizeof(err));
+    if (r) {
+        fprintf(stderr, "%s: %s\n", path, err);
+        return -1;
+    }
+    config_reload_t *cr = NULL;
+    r = config_reload_start(path, cfg, CONFIG_RELOAD_HOLD, &cr);
+    if (!r)
+        r = master_group_set_reload(g, cr);
+    if (r) {
+        fprintf(stderr, "Failed to start config reload: %s\n", strerror(-r));
+        config_reload_stop(cr);
+        master_group_destroy(g);
+        return -1;
+    }
+    for (unsigned int i = 0; i < master_group_count(g); i++) {
+        master_member_t *m = master_group_member(g, i);
+        touch_probe_arm(m->probe, m->axes->probe_mask);
+    }
+    /* 遥测不是控制必需项，失败时仅告警 */
+    r = master_group_set_telemetry(g, TELEMETRY_SHM_DEFAULT_NAME, TELEMETRY_DECIMATION);
+    if (r)
+        fprintf(stderr, "Telemetry segments unavailable: %s\n", strerror(-r));
+
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+    r = master_group_start(g);
+    if (r) {
+        fprintf(stderr, "Failed to start master group: %s\n", strerror(-r));
+        config_reload_stop(cr);
+        master_group_destroy(g);
+        return -1;
+    }
+    printf("%u masters running, Ctrl+C to stop\n", master_group_count(g));
+
+    uint32_t last_generation = 0;
+    while (run) {
+        sleep(1);
+        for (unsigned int i = 0; i < master_group_count(g); i++) {
+            master_member_t *m = master_group_member(g, i);
+            master_stats_t st;
+            master_group_get_stats(g, i, &st);
+            printf("master %d: cycles %llu  misses %llu  skipped %llu  stale %llu  "
+                   "latency %u ns  exec %u ns%s\n", m->index,
+                   (unsigned long long)st.sched.cycles,
+                   (unsigned long long)st.sched.deadline_misses,
+                   (unsigned long long)st.sched.skipped, (unsigned long long)st.stale_frames,
+                   st.wake_latency_max_ns, st.exec_max_ns, st.sched.safe_state ? "  SAFE" : "");
 
-    printf("hello world");
+            touch_probe_capture_t c;
+            while (touch_probe_pop(m->probe, &c) == 1)
+                printf("  probe axis %d  %.4f (%d)  cycle %llu\n", c.axis_id, c.position, c.raw,
+                       (unsigned long long)c.cycle);
+            if (m->modbus) {
+                modbus_gw_stats_t ms;
+                modbus_gw_get_stats(m->modbus, &ms);
+                printf("  modbus requests %llu  transactions %llu  errors %llu  timeouts %llu\n",
+                       (unsigned long long)ms.requests, (unsigned long long)ms.transactions,
+                       (unsigned long long)ms.errors, (unsigned long long)ms.timeouts);
+            }
+        }
+        diag_event_t ev;
+        while (diag_ring_pop(master_group_diag(g), &ev))
+            printf("  diag master %u  %s  cycle %llu  value %lld\n", ev.source,
+                   diag_code_name(ev.code), (unsigned long long)ev.cycle, (long long)ev.value);
+
+        config_reload_status_t rs;
+        config_reload_get_status(cr, &rs);
+        if (rs.generation != last_generation || rs.pending)
+            printf("  config generation %u  applied %u  rejected %u%s  %s\n", rs.generation,
+                   rs.applied, rs.rejected, rs.pending ? "  (held)" : "", rs.last_error);
+        last_generation = rs.generation;
+    }
+
+    master_group_stop(g);
+    config_reload_stop(cr);
+    master_group_destroy(g);
     return 0;
 }
+
+/*
+ * 离线校验配置文件：解析 + 与上面的 PDO 映射逐项比对，不需要连接主站。
+ * 加 --run 时校验通过后按配置启动多主站周期任务 (需要主站与从站在线)。
+ * 用法: ./test_all [--run] [config.json]
+ */
+int main (int argc, char **argv)
+{
+    int run_mode = argc > 1 && !strcmp(argv[1], "--run");
+    if (run_mode) {
+        argc--;
+        argv++;
+    }
+    const char *path = argc > 1 ? argv[1] : "doc/test_all_config.json";
+    axis_config_table_t cfg;
+    char err[256];
+
+    if (axis_config_load(path, &cfg, err, sizeof(err))) {
+        fprintf(stderr, "%s: %s\n", path, err);
+        return -1;
+    }
+
+    axis_table_t *at = NULL;
+    if (axis_table_create(&cfg, bus_slaves, sizeof(bus_slaves) / sizeof(bus_slaves[0]),
+                          &at, err, sizeof(err))) {
+        fprintf(stderr, "%s: %s\n", path, err);
+        axis_config_free(&cfg);
+        return -1;
+    }
+
+    analog_pipeline_t *ap = NULL;
+    if (analog_pipeline_create(cfg.analog, cfg.n_analog, bus_slaves,
+                               sizeof(bus_slaves) / sizeof(bus_slaves[0]), NULL, 0, &ap, err,
+                               sizeof(err))) {
+        fprintf(stderr, "%s: %s\n", path, err);
+        axis_table_destroy(at);
+        axis_config_free(&cfg);
+        return -1;
+    }
+
+    di_edge_t *di = NULL;
+    if (di_edge_create(cfg.di, cfg.n_di, bus_slaves, sizeof(bus_slaves) / sizeof(bus_slaves[0]),
+                       cfg.cycle_us, &di, err, sizeof(err))) {
+        fprintf(stderr, "%s: %s\n", path, err);
+        analog_pipeline_destroy(ap);
+        axis_table_destroy(at);
+        axis_config_free(&cfg);
+        return -1;
+    }
+
+    /* modbus_gateway 从站需映射网关协议的全部对象 */
+    int gw_slave = -1;
+    for (unsigned int i = 0; i < cfg.n_slaves; i++) {
+        if (!cfg.slaves[i].modbus_gateway)
+            continue;
+        const axis_slave_desc_t *sd = NULL;
+        for (unsigned int s = 0; s < sizeof(bus_slaves) / sizeof(bus_slaves[0]); s++) {
+            if (bus_slaves[s].position == cfg.slaves[i].id)
+                sd = &bus_slaves[s];
+        }
+        if (!sd)
+            snprintf(err, sizeof(err), "modbus gateway slave %d not on bus", cfg.slaves[i].id);
+        if (!sd || modbus_gw_check(sd, err, sizeof(err))) {
+            fprintf(stderr, "%s: %s\n", path, err);
+            di_edge_destroy(di);
+            analog_pipeline_destroy(ap);
+            axis_table_destroy(at);
+            axis_config_free(&cfg);
+            return -1;
+        }
+        gw_slave = cfg.slaves[i].id;
+    }
+
+    printf("%s: %u slaves, %u axes, %u PDO entries, %u analog channels, cycle %u us\n", path,
+           cfg.n_slaves, at->n_axes, at->n_regs, cfg.n_analog, cfg.cycle_us);
+    for (unsigned int i = 0; i < at->n_axes; i++) {
+        printf("  axis %4d  slave %u  %-6s  scale %.6f%s\n", at->axis_id[i], at->slave_pos[i],
+               at->type[i] == SLAVE_TYPE_IO ? "io" : "cia402", at->scale[i],
+               axis_mask_test(at->probe_mask, i) ? "  probe" : "");
+    }
+    for (unsigned int i = 0; i < cfg.n_analog; i++) {
+        const analog_config_t *an = &cfg.analog[i];
+        printf("  analog %-12s slave %d  0x%04X  median %u  avg %u  iir %.3f\n", an->name,
+               an->slave_id, an->index, an->median, an->avg_window, an->iir_alpha);
+    }
+    for (unsigned int i = 0; i < cfg.n_di; i++)
+        printf("  digital input slave %d  0x%04X  first bit %d\n", cfg.di[i].slave_id,
+               cfg.di[i].index, di_edge_bit(di, cfg.di[i].slave_id, cfg.di[i].index, 0));
+    if (gw_slave >= 0)
+        printf("  modbus gateway on slave %d\n", gw_slave);
+
+    di_edge_destroy(di);
+    analog_pipeline_destroy(ap);
+    axis_table_destroy(at);
+    int ret = run_mode ? run_group(path, &cfg) : 0;
+    axis_config_free(&cfg);
+    return ret;
+}
@@ -10,14 +10,24 @@
  * 3. 注册 PDO Entry (Output: 0x7000:01-09, Input: 0x6000:00)
  * 4. 激活主站并进入循环
  * 5. 每秒翻转一次输出 (0x00 <-> 0xFF)
+ * 6. 每 TELEMETRY_DECIMATION 个周期向共享内存 /ecat_telemetry 发布一次快照
+ *    (外部可用 telemetry_dump 读取)
+ * 7. 周期由 cycle_sched 调度：错过截止时间按策略跳过或补跑，连续错过
+ *    SAFE_AFTER_MISSES 个周期后输出全部清零 (安全态)，事件每秒从诊断环打印一次
+ * 8. 每周期由 health_monitor 检查 WKC / 链路 / 从站状态，变化写入同一诊断环
+ * 9. AD_INPUT_1/2 经 analog_pipeline 标定为电压 (0x0FFF = 10V) 并做中值 + 滑动平均滤波
+ * 10. 0x6000 / INPUT_1_16 (0x6005) 经 di_edge 做边沿检测，INPUT_1 的上升/下降沿在分发线程中打印
+ *
+ * 用法: ./test_io_raw [skip|catchup] [safe_after_misses]
  *
  * 编译:
- * gcc -o test_io_raw test_io_raw.c -I/usr/local/include -lethercat -lpthread -lrt
+ * gcc -o test_io_raw test_io_raw.c telemetry_shm.c cycle_sched.c diag_ring.c health_monitor.c analog_pipeline.c di_edge.c spsc_ring.c -I../include -I/usr/local/include -lethercat -lpthread -lrt
  */
 
 #include <errno.h>
 #include <signal.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/resource.h>
 #include <sys/time.h>
@@ -26,7 +36,13 @@
 #include <time.h>
 #include <stdint.h>
 
+#include "analog_pipeline.h"
+#include "cycle_sched.h"
+#include "di_edge.h"
+#include "diag_ring.h"
 #include "ecrt.h"
+#include "health_monitor.h"
+#include "telemetry_shm.h"
 
 // --- 配置参数 ---
 #define CYCLE_US 4000  // 4ms 周期
@@ -34,6 +50,9 @@
 #define BusPos   0
 #define VendorID 0x00000025
 #define ProductCode 0x00000530
+#define TELEMETRY_DECIMATION 1  // 每周期发布一次遥测快照
+#define SAFE_AFTER_MISSES 5     // 默认连续错过 5 个截止时间进入安全态
+#define DIAG_DRAIN_CYCLES 250   // 每 250 个周期 (1秒) 打印一次诊断事件
 
 // --- PDO 偏移量变量 ---
 static unsigned int off_output_1; // 0x7000:01
@@ -85,6 +104,25 @@ const static ec_pdo_entry_reg_t domain1_regs[] = {
     {},
 };
 
+// --- 遥测字段 (名称对应 io_board.xml / 接线定义) ---
+static const telemetry_source_t telemetry_sources[] = {
+    {"OUTPUT_1_16",  BusPos, 0x7000, 6, TELEMETRY_U16, &off_output_6},
+    {"AD_OUTPUT_1",  BusPos, 0x7000, 7, TELEMETRY_U16, &off_output_7},
+    {"AD_OUTPUT_2",  BusPos, 0x7000, 8, TELEMETRY_U16, &off_output_8},
+    {"IN_0x6000",    BusPos, 0x6000, 0, TELEMETRY_U32, &off_input_0},
+    {"IN_0x6001",    BusPos, 0x6001, 0, TELEMETRY_U32, &off_input_1},
+    {"IN_0x6002",    BusPos, 0x6002, 0, TELEMETRY_U16, &off_input_2},
+    {"IN_0x6003",    BusPos, 0x6003, 0, TELEMETRY_U16, &off_input_3},
+    {"IN_0x6004",    BusPos, 0x6004, 0, TELEMETRY_U32, &off_input_4},
+    {"INPUT_1_16",   BusPos, 0x6005, 0, TELEMETRY_U16, &off_input_5},
+    {"AD_INPUT_1",   BusPos, 0x6006, 0, TELEMETRY_U16, &off_input_6},
+    {"AD_INPUT_2",   BusPos, 0x6007, 0, TELEMETRY_U16, &off_input_7},
+    {"IN_0x6008",    BusPos, 0x6008, 0, TELEMETRY_U32, &off_input_8},
+    {"IN_0x6009",    BusPos, 0x6009, 0, TELEMETRY_U32, &off_input_9},
+    {"IN_0x600a",    BusPos, 0x600a, 0, TELEMETRY_U32, &off_input_10},
+    {"IN_0x600b",    BusPos, 0x600b, 0, TELEMETRY_U32, &off_input_11},
+};
+
 // --- PDO 配置 (基于 io_board.xml) ---
 // RxPDO 0x1600 (Output)
 static ec_pdo_entry_info_t slave_0_pdo_entries_1600[] = {
@@ -128,20 +166,44 @@ static ec_sync_info_t slave_0_syncs[] = {
     {0xff}
 };
 
+// --- 模拟量通道 (AD_INPUT_1/2，0 ~ 0x0FFF 对应 0 ~ 10V) ---
+static const analog_config_t analog_channels[] = {
+    {.name = "AD_INPUT_1", .slave_id = BusPos, .index = 0x6006, .median = 3, .avg_window = 4,
+     .gain = 10.0 / 0x0FFF, .iir_alpha = 1.0},
+    {.name = "AD_INPUT_2", .slave_id = BusPos, .index = 0x6007, .median = 3, .avg_window = 4,
+     .gain = 10.0 / 0x0FFF, .iir_alpha = 1.0},
+};
+
+// --- 做边沿检测的数字量输入字 ---
+static const di_config_t di_words[] = {
+    {.slave_id = BusPos, .index = 0x6000},
+    {.slave_id = BusPos, .index = 0x6005},  // INPUT_1_16
+};
+
 static volatile int run = 1;
 
 void signal_handler(int sig) {
     run = 0;
 }
 
-// 简单的周期等待函数 (CLOCK_MONOTONIC)
-void sleep_until(struct timespec *ts, long delay_us) {
-    ts->tv_nsec += delay_us * 1000;
-    while (ts->tv_nsec >= 1000000000) {
-        ts->tv_nsec -= 1000000000;
-        ts->tv_sec++;
+// 分发线程中调用：打印 INPUT_1 的边沿
+static void on_input_edge(const di_edge_event_t *ev, void *arg) {
+    (void)arg;
+    printf("[di] INPUT_1 %s at cycle %lu\n", ev->edge == DI_EDGE_RISING ? "rising" : "falling",
+           (unsigned long)ev->cycle);
+}
+
+// 打印并清空诊断环中的事件
+static void drain_diag(diag_ring_t *diag) {
+    diag_event_t ev;
+    if (!diag)
+        return;
+    while (diag_ring_pop(diag, &ev)) {
+        printf("[diag] %lu.%09lu cycle %lu %s %u %ld\n",
+               (unsigned long)(ev.timestamp_ns / 1000000000ull),
+               (unsigned long)(ev.timestamp_ns % 1000000000ull),
+               (unsigned long)ev.cycle, diag_code_name(ev.code), ev.detail, (long)ev.value);
     }
-    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, ts, NULL);
 }
 
 int main(int argc, char **argv) {
@@ -180,8 +242,27 @@ int main(int argc, char **argv) {
         return -1;
     }
 
+    analog_pipeline_t *analog = NULL;
+    const axis_slave_desc_t bus_slave = {BusAlias, BusPos, VendorID, ProductCode, slave_0_syncs};
+    char why[160];
+    if (analog_pipeline_create(analog_channels, sizeof(analog_channels) / sizeof(analog_channels[0]),
+                               &bus_slave, 1, NULL, 0, &analog, why, sizeof(why))) {
+        fprintf(stderr, "Analog pipeline: %s\n", why);
+        return -1;
+    }
+    di_edge_t *di = NULL;
+    if (di_edge_create(di_words, sizeof(di_words) / sizeof(di_words[0]), &bus_slave, 1, CYCLE_US,
+                       &di, why, sizeof(why))) {
+        fprintf(stderr, "DI edge: %s\n", why);
+        return -1;
+    }
+    di_edge_subscribe(di, (unsigned int)di_edge_bit(di, BusPos, 0x6005, 0), DI_EDGE_BOTH,
+                      on_input_edge, NULL);
+
     printf("Registering PDO entries...\n");
-    if (ecrt_domain_reg_pdo_entry_list(domain1, domain1_regs)) {
+    if (ecrt_domain_reg_pdo_entry_list(domain1, domain1_regs) ||
+        ecrt_domain_reg_pdo_entry_list(domain1, analog_pipeline_regs(analog)) ||
+        ecrt_domain_reg_pdo_entry_list(domain1, di_edge_regs(di))) {
         fprintf(stderr, "PDO entry registration failed.\n");
         return -1;
     }
@@ -197,6 +278,17 @@ int main(int argc, char **argv) {
         fprintf(stderr, "Failed to retrieve domain data pointer.\n");
         return -1;
     }
+    analog_pipeline_bind(analog, domain1_pd);
+    di_edge_bind(di, domain1_pd);
+
+    telemetry_shm_t *tlm = NULL;
+    int tlm_err = telemetry_shm_create(TELEMETRY_SHM_DEFAULT_NAME, telemetry_sources,
+                                       sizeof(telemetry_sources) / sizeof(telemetry_sources[0]),
+                                       TELEMETRY_DECIMATION, CYCLE_US, &tlm);
+    if (tlm_err) {
+        // 遥测不是控制必需项，失败时仅告警
+        fprintf(stderr, "Telemetry segment unavailable: %s\n", strerror(-tlm_err));
+    }
 
     printf("Started.\n");
 
@@ -204,15 +296,60 @@ int main(int argc, char **argv) {
     clock_gettime(CLOCK_MONOTONIC, &wakeup_time);
     printf("wakeup_time: %ld.%09ld\n", wakeup_time.tv_sec, wakeup_time.tv_nsec);
 
+    // 周期调度：第 0 个时隙为启动后一个周期
+    diag_ring_t *diag = NULL;
+    cycle_sched_t *sched = NULL;
+    cycle_sched_config_t sched_cfg = {
+        .period_ns = CYCLE_US * 1000,
+        .policy = (argc > 1 && !strcmp(argv[1], "catchup")) ? CYCLE_OVERRUN_CATCHUP
+                                                             : CYCLE_OVERRUN_SKIP,
+        .safe_after = argc > 2 ? (unsigned int)atoi(argv[2]) : SAFE_AFTER_MISSES,
+    };
+    if (diag_ring_create(256, &diag) == 0)
+        sched_cfg.diag = diag;
+    uint64_t start_ns = (uint64_t)wakeup_time.tv_sec * 1000000000ull + wakeup_time.tv_nsec +
+                        CYCLE_US * 1000ull;
+    if (cycle_sched_create(&sched_cfg, start_ns, &sched)) {
+        fprintf(stderr, "Failed to create cycle scheduler.\n");
+        return -1;
+    }
+    printf("Overrun policy: %s, safe state after %u misses\n",
+           sched_cfg.policy == CYCLE_OVERRUN_CATCHUP ? "catchup" : "skip", sched_cfg.safe_after);
+
+    // 总线健康监视：domain1 的 WKC、主站链路、slave 0 的 AL 状态
+    health_monitor_t *health = NULL;
+    const uint16_t health_pos = BusPos;
+    health_monitor_config_t health_cfg = {
+        .master = master,
+        .domains = &domain1,
+        .n_domains = 1,
+        .slaves = &sc,
+        .slave_pos = &health_pos,
+        .n_slaves = 1,
+        .diag = diag,
+    };
+    if (health_monitor_create(&health_cfg, &health)) {
+        fprintf(stderr, "Failed to create health monitor.\n");
+        return -1;
+    }
+
     int counter = 0;
     uint32_t output_val = 0;
+    telemetry_stats_t stats = {0};
+    struct timespec cycle_start, last_start = wakeup_time, cycle_end;
+    cycle_tick_t tick;
 
     while (run) {
-        sleep_until(&wakeup_time, CYCLE_US);
+        cycle_sched_wait(sched, &tick);
+        clock_gettime(CLOCK_MONOTONIC, &cycle_start);
 
         // 接收数据
         ecrt_master_receive(master);
         ecrt_domain_process(domain1);
+        health_monitor_cycle(health, tick.cycle);
+        analog_pipeline_cycle(analog, tick.cycle);
+        di_edge_cycle(di, tick.cycle, tick.slot_ns);
+        const float *volts = analog_pipeline_values(analog);
 
         // 闪烁逻辑 (每 250 个周期 / 1秒 翻转一次)
         if (counter++ % 500 == 0) {
@@ -230,9 +367,16 @@ int main(int argc, char **argv) {
         EC_WRITE_U32(domain1_pd + off_output_5, 0X0000);
 
 
-        EC_WRITE_U16(domain1_pd + off_output_6, output_val);//OUTPUT_1~16
-        EC_WRITE_U16(domain1_pd + off_output_7, 0x07ff);//AD_OUTPUT_1
-        EC_WRITE_U16(domain1_pd + off_output_8, 0x0fff);//AD_OUTPUT_2
+        if (tick.safe_state) {
+            // 安全态：数字/模拟输出全部清零，锁存到 cycle_sched_clear_safe() (本程序不调用，保持到退出)
+            EC_WRITE_U16(domain1_pd + off_output_6, 0x0000);
+            EC_WRITE_U16(domain1_pd + off_output_7, 0x0000);
+            EC_WRITE_U16(domain1_pd + off_output_8, 0x0000);
+        } else {
+            EC_WRITE_U16(domain1_pd + off_output_6, output_val);//OUTPUT_1~16
+            EC_WRITE_U16(domain1_pd + off_output_7, 0x07ff);//AD_OUTPUT_1
+            EC_WRITE_U16(domain1_pd + off_output_8, 0x0fff);//AD_OUTPUT_2
+        }
         EC_WRITE_U32(domain1_pd + off_output_9, 0X00000000);
         
         uint32_t input_val_0 = EC_READ_U32(domain1_pd + off_input_0);
@@ -255,8 +399,8 @@ int main(int argc, char **argv) {
         printf("input_val_3: 0x%04X\n", input_val_3);
         printf("input_val_4: 0x%08X\n", input_val_4);
         printf("input_val_5: 0x%04X\n", input_val_5);//INPUT_1~16
-        printf("input_val_6: 0x%04X (%.2fV)\n", input_val_6, (float)input_val_6/0x0FFF*10.0);//AD_INPUT_1
-        printf("input_val_7: 0x%04X (%.2fV)\n", input_val_7, (float)input_val_7/0x0FFF*10.0);//AD_INPUT_2
+        printf("input_val_6: 0x%04X (%.2fV)\n", input_val_6, volts[0]);//AD_INPUT_1
+        printf("input_val_7: 0x%04X (%.2fV)\n", input_val_7, volts[1]);//AD_INPUT_2
         printf("input_val_8: 0x%08X\n", input_val_8);
         printf("input_val_9: 0x%08X\n", input_val_9);
         printf("input_val_10: 0x%08X\n", input_val_10);
@@ -267,8 +411,61 @@ int main(int argc, char **argv) {
         //printf("wakeup_time: %ld.%09ld\n", wakeup_time.tv_sec, wakeup_time.tv_nsec);
         ecrt_domain_queue(domain1);
         ecrt_master_send(master);
+        cycle_sched_done(sched);
+
+        // 周期统计 + 遥测快照
+        clock_gettime(CLOCK_MONOTONIC, &cycle_end);
+        stats.cycle++;
+        stats.timestamp_ns = (uint64_t)cycle_start.tv_sec * 1000000000ull + cycle_start.tv_nsec;
+        stats.period_ns = (uint32_t)((cycle_start.tv_sec - last_start.tv_sec) * 1000000000L +
+                                     (cycle_start.tv_nsec - last_start.tv_nsec));
+        stats.exec_ns = (uint32_t)((cycle_end.tv_sec - cycle_start.tv_sec) * 1000000000L +
+                                   (cycle_end.tv_nsec - cycle_start.tv_nsec));
+        if (stats.cycle > 1 && stats.period_ns > stats.period_max_ns)
+            stats.period_max_ns = stats.period_ns;
+        if (stats.exec_ns > stats.exec_max_ns)
+            stats.exec_max_ns = stats.exec_ns;
+        last_start = cycle_start;
+        cycle_sched_stats_t sched_st;
+        cycle_sched_get_stats(sched, &sched_st);
+        stats.deadline_misses = sched_st.deadline_misses;
+        stats.skipped = sched_st.skipped;
+        stats.caught_up = sched_st.caught_up;
+        stats.max_lateness_ns = sched_st.max_lateness_ns;
+        stats.safe_state = (uint32_t)sched_st.safe_state;
+        telemetry_shm_publish(tlm, domain1_pd, &stats);
+
+        if (counter % DIAG_DRAIN_CYCLES == 0)
+            drain_diag(diag);
     }
 
+    drain_diag(diag);
+    cycle_sched_stats_t sst;
+    cycle_sched_get_stats(sched, &sst);
+    printf("Cycles %lu, deadline misses %lu, skipped %lu, caught up %lu, max lateness %u ns%s\n",
+           (unsigned long)sst.cycles, (unsigned long)sst.deadline_misses,
+           (unsigned long)sst.skipped, (unsigned long)sst.caught_up, sst.max_lateness_ns,
+           sst.safe_state ? ", in safe state" : "");
+    health_master_stats_t hms;
+    health_domain_stats_t hds;
+    health_monitor_master_stats(health, &hms);
+    health_monitor_domain_stats(health, 0, &hds);
+    printf("WKC %u/%u, mismatch cycles %lu (%u events), lost frames %lu (%u events), "
+           "link down %u, slaves responding %u\n",
+           hds.working_counter, hds.expected_wkc, (unsigned long)hds.wkc_mismatches,
+           hds.mismatch_events, (unsigned long)hds.lost_frames, hds.lost_events,
+           hms.link_down_events, hms.slaves_responding);
+    di_edge_stats_t dst;
+    di_edge_get_stats(di, &dst);
+    printf("DI edges %lu (%lu word changes, %lu dropped)\n", (unsigned long)dst.edges,
+           (unsigned long)dst.changes, (unsigned long)dst.dropped);
+    health_monitor_destroy(health);
+    analog_pipeline_destroy(analog);
+    di_edge_destroy(di);
+    cycle_sched_destroy(sched);
+    diag_ring_destroy(diag);
+    telemetry_shm_destroy(tlm);
+
     printf("Releasing master...\n");
     ecrt_release_master(master);
     return 0;
@@ -0,0 +1,191 @@
+/*
+ * touch_probe.c
+ *
+ * 探针捕获实现，接口说明见 touch_probe.h。
+ *
+ * arm / disarm 请求是按轴位图的原子字，应用线程 fetch_or，周期任务 exchange 取走；
+ * 其余状态 (各阶段位图、上一周期的状态字) 只由周期任务访问。
+ */
+
+#include "touch_probe.h"
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include "spsc_ring.h"
+
+struct touch_probe {
+    const axis_table_t *at;
+    unsigned int        words;
+    uint16_t            enable_fn;   /* 写入 0x60b8 的使能字 */
+    int                 continuous;
+
+    _Atomic uint64_t   *arm_req;
+    _Atomic uint64_t   *disarm_req;
+
+    /* 周期任务独占 */
+    uint64_t           *resetting;   /* 已写 0，等待驱动器清除探针状态后写使能字 */
+    uint64_t           *armed;
+    uint16_t           *last_status;
+    spsc_ring_t        *ring;
+
+    _Atomic uint64_t    captures;
+    _Atomic uint64_t    dropped;
+    _Atomic uint64_t    arms;
+};
+
+#define INC(x) atomic_fetch_add_explicit(&(x), 1, memory_order_relaxed)
+
+int touch_probe_create(const axis_table_t *at, const touch_probe_config_t *cfg,
+                       touch_probe_t **out)
+{
+    if (!at || !out)
+        return -EINVAL;
+
+    touch_probe_t *tp = calloc(1, sizeof(*tp));
+    if (!tp)
+        return -ENOMEM;
+    unsigned int words = AXIS_MASK_WORDS(at->n_axes ? at->n_axes : 1);
+    tp->at = at;
+    tp->words = words;
+    tp->continuous = cfg && cfg->continuous;
+    tp->enable_fn = TOUCH_PROBE_FN_ENABLE | TOUCH_PROBE_FN_POS_EDGE;
+    if (tp->continuous)
+        tp->enable_fn |= TOUCH_PROBE_FN_CONTINUOUS;
+    if (cfg && cfg->zero_pulse)
+        tp->enable_fn |= TOUCH_PROBE_FN_ZERO_PULSE;
+
+    tp->arm_req = calloc(words, sizeof(*tp->arm_req));
+    tp->disarm_req = calloc(words, sizeof(*tp->disarm_req));
+    tp->resetting = calloc(words, sizeof(*tp->resetting));
+    tp->armed = calloc(words, sizeof(*tp->armed));
+    tp->last_status = calloc(at->n_axes ? at->n_axes : 1, sizeof(*tp->last_status));
+    unsigned int cap = cfg && cfg->capacity ? cfg->capacity : TOUCH_PROBE_DEFAULT_CAPACITY;
+    int r = -ENOMEM;
+    if (tp->arm_req && tp->disarm_req && tp->resetting && tp->armed && tp->last_status)
+        r = spsc_ring_create(cap, sizeof(touch_probe_capture_t), &tp->ring);
+    if (r) {
+        touch_probe_destroy(tp);
+        return r;
+    }
+    for (unsigned int w = 0; w < words; w++) {
+        atomic_init(&tp->arm_req[w], 0);
+        atomic_init(&tp->disarm_req[w], 0);
+    }
+    atomic_init(&tp->captures, 0);
+    atomic_init(&tp->dropped, 0);
+    atomic_init(&tp->arms, 0);
+    *out = tp;
+    return 0;
+}
+
+void touch_probe_arm(touch_probe_t *tp, const uint64_t *mask)
+{
+    for (unsigned int w = 0; w < tp->words; w++) {
+        uint64_t m = mask[w] & tp->at->probe_mask[w];
+        if (m)
+            atomic_fetch_or_explicit(&tp->arm_req[w], m, memory_order_release);
+    }
+}
+
+void touch_probe_disarm(touch_probe_t *tp, const uint64_t *mask)
+{
+    for (unsigned int w = 0; w < tp->words; w++) {
+        uint64_t m = mask[w] & tp->at->probe_mask[w];
+        if (m)
+            atomic_fetch_or_explicit(&tp->disarm_req[w], m, memory_order_release);
+    }
+}
+
+void touch_probe_cycle(touch_probe_t *tp, uint64_t cycle, uint64_t time_ns)
+{
+    if (!tp || !tp->at->bound)
+        return;
+    const axis_table_t *at = tp->at;
+
+    for (unsigned int w = 0; w < tp->words; w++) {
+        /*
+         * 驱动器确认探针已关闭 (状态位清零) 后写入使能字。基准取锁存位清零的状态：使能后
+         * 第一个周期就到达的锁存也表现为锁存位变化，不会被当作基准吞掉。
+         */
+        for (uint64_t bits = tp->resetting[w]; bits; bits &= bits - 1) {
+            unsigned int i = w * 64u + (unsigned int)__builtin_ctzll(bits);
+            uint16_t st = EC_READ_U16(at->probe_status[i]);
+            if (st & TOUCH_PROBE_ST_ENABLED)
+                continue;
+            EC_WRITE_U16(at->probe_func[i], tp->enable_fn);
+            tp->last_status[i] = st & (uint16_t)~TOUCH_PROBE_ST_POS_STORED;
+            tp->resetting[w] &= ~(1ull << (i % 64u));
+            tp->armed[w] |= 1ull << (i % 64u);
+            INC(tp->arms);
+        }
+
+        uint64_t dis = 0, arm = 0;
+        if (atomic_load_explicit(&tp->disarm_req[w], memory_order_relaxed))
+            dis = atomic_exchange_explicit(&tp->disarm_req[w], 0, memory_order_acquire);
+        if (atomic_load_explicit(&tp->arm_req[w], memory_order_relaxed))
+            arm = atomic_exchange_explicit(&tp->arm_req[w], 0, memory_order_acquire);
+        /* arm 先写 0：驱动器清除锁存状态，并能看到使能位的上升沿 (单次模式重新 arm 依赖于此) */
+        for (uint64_t bits = dis | arm; bits; bits &= bits - 1) {
+            unsigned int i = w * 64u + (unsigned int)__builtin_ctzll(bits);
+            EC_WRITE_U16(at->probe_func[i], 0);
+        }
+        tp->armed[w] &= ~(dis | arm);
+        tp->resetting[w] = (tp->resetting[w] | arm) & ~dis;
+
+        for (uint64_t bits = tp->armed[w]; bits; bits &= bits - 1) {
+            unsigned int i = w * 64u + (unsigned int)__builtin_ctzll(bits);
+            uint16_t st = EC_READ_U16(at->probe_status[i]);
+            if (!(st & TOUCH_PROBE_ST_ENABLED))
+                continue;  /* 驱动器尚未响应使能字，保持基准 */
+            uint16_t prev = tp->last_status[i];
+            tp->last_status[i] = st;
+            uint16_t changed = (uint16_t)(st ^ prev) & TOUCH_PROBE_ST_POS_STORED;
+            if (!changed || (!tp->continuous && !(st & TOUCH_PROBE_ST_POS_STORED)))
+                continue;
+
+            touch_probe_capture_t c = {
+                .axis = i,
+                .axis_id = at->axis_id[i],
+                .raw = EC_READ_S32(at->probe_pos[i]),
+                .cycle = cycle,
+                .time_ns = time_ns,
+            };
+            c.position = (double)c.raw * at->inv_scale[i];
+            if (spsc_ring_push(tp->ring, &c))
+                INC(tp->dropped);
+            else
+                INC(tp->captures);
+            /* 单次模式：驱动器保持锁存直到重新使能，解除后由应用重新 arm */
+            if (!tp->continuous)
+                tp->armed[w] &= ~(1ull << (i % 64u));
+        }
+    }
+}
+
+int touch_probe_pop(touch_probe_t *tp, touch_probe_capture_t *out)
+{
+    return spsc_ring_pop(tp->ring, out);
+}
+
+void touch_probe_get_stats(const touch_probe_t *tp, touch_probe_stats_t *st)
+{
+    touch_probe_t *m = (touch_probe_t *)tp;
+    st->captures = atomic_load_explicit(&m->captures, memory_order_relaxed);
+    st->dropped = atomic_load_explicit(&m->dropped, memory_order_relaxed);
+    st->arms = atomic_load_explicit(&m->arms, memory_order_relaxed);
+}
+
+void touch_probe_destroy(touch_probe_t *tp)
+{
+    if (!tp)
+        return;
+    spsc_ring_destroy(tp->ring);
+    free(tp->arm_req);
+    free(tp->disarm_req);
+    free(tp->resetting);
+    free(tp->armed);
+    free(tp->last_status);
+    free(tp);
+}